@@ -0,0 +1,231 @@
+//
+//  BlockStore.hpp
+//  BlockGuard
+//
+//  One immutable block tree shared by every Blockchain in the process. A
+//  block is stored once per (parent, hash, publishers) and a chain is only a handle on
+//  its tip, so copying or adopting a chain is a pointer copy whatever its
+//  length, and peers that hold the same blocks hold them once.
+//
+
+#ifndef BlockStore_hpp
+#define BlockStore_hpp
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "Block.hpp"
+
+class BlockNode : public std::enable_shared_from_this<BlockNode>{
+protected:
+    Block                                       _block;
+    std::shared_ptr<const BlockNode>            _parent;
+    const BlockNode                            *_skip; // ancestor at skipHeight(_height), held alive through _parent
+    int                                         _height;
+
+    static int          skipHeight          (int height);
+
+public:
+    BlockNode                                   (const Block &block, const std::shared_ptr<const BlockNode> &parent);
+    BlockNode                                   (const BlockNode&) = delete;
+    ~BlockNode                                  ();
+
+    const Block&        block               ()const                                         {return _block;};
+    const BlockNode*    parent              ()const                                         {return _parent.get();};
+    const std::shared_ptr<const BlockNode>& parentHandle()const                             {return _parent;};
+    int                 height              ()const                                         {return _height;};
+    // the block at height on the way back to genesis, O(log n) through the skip pointers
+    const BlockNode*    ancestor            (int height)const;
+    // the deepest block two chains share, nullptr if they do not share genesis. Blocks on both chains
+    // are the same node in the store so nothing is compared by content, O(log depth) ancestor lookups
+    static const BlockNode* lastCommonAncestor(const BlockNode *a, const BlockNode *b);
+
+    BlockNode&          operator=           (const BlockNode&) = delete;
+};
+
+// heights whose skips stay close together so a walk is O(log n) (the same scheme as Bitcoin's block index)
+inline int BlockNode::skipHeight(int height){
+    if(height < 2){
+        return 0;
+    }
+    // height with its lowest set bit cleared
+    auto lowered = [](int h){return h & (h - 1);};
+    return (height & 1) ? lowered(lowered(height - 1)) + 1 : lowered(height);
+}
+
+inline BlockNode::BlockNode(const Block &block, const std::shared_ptr<const BlockNode> &parent) : _block(block), _parent(parent){
+    _height = (parent == nullptr ? 0 : parent->height() + 1);
+    _skip = (parent == nullptr ? nullptr : parent->ancestor(skipHeight(_height)));
+}
+
+// a long chain would otherwise be freed one recursive call per block
+inline BlockNode::~BlockNode(){
+    std::shared_ptr<const BlockNode> next = std::move(_parent);
+    while(next != nullptr && next.use_count() == 1){
+        std::shared_ptr<const BlockNode> up = std::move(const_cast<BlockNode&>(*next)._parent);
+        next = std::move(up);
+    }
+}
+
+inline const BlockNode* BlockNode::ancestor(int height)const{
+    if(height > _height || height < 0){
+        return nullptr;
+    }
+    const BlockNode *walk = this;
+    int walkHeight = _height;
+    while(walkHeight > height){
+        int heightSkip = skipHeight(walkHeight);
+        int heightSkipPrev = skipHeight(walkHeight - 1);
+        // take the skip unless it overshoots or the parent's skip lands closer
+        if(walk->_skip != nullptr && (heightSkip == height || (heightSkip > height && !(heightSkipPrev < heightSkip - 2 && heightSkipPrev >= height)))){
+            walk = walk->_skip;
+            walkHeight = heightSkip;
+        }else{
+            walk = walk->parent();
+            walkHeight--;
+        }
+    }
+    return walk;
+}
+
+inline const BlockNode* BlockNode::lastCommonAncestor(const BlockNode *a, const BlockNode *b){
+    if(a == nullptr || b == nullptr){
+        return nullptr;
+    }
+    if(a->height() > b->height()){
+        a = a->ancestor(b->height());
+    }else if(b->height() > a->height()){
+        b = b->ancestor(a->height());
+    }
+    if(a == b){
+        return a;
+    }
+    // step down from the tips in doubling strides until the chains agree, then bisect the last stride
+    const int top = a->height();
+    int differs = top;
+    int agrees = -1;
+    for(int stride = 1; agrees == -1; stride *= 2){
+        int height = std::max(top - stride, 0);
+        if(a->ancestor(height) == b->ancestor(height)){
+            agrees = height;
+        }else if(height == 0){
+            return nullptr;
+        }else{
+            differs = height;
+        }
+    }
+    while(differs - agrees > 1){
+        int middle = agrees + (differs - agrees) / 2;
+        if(a->ancestor(middle) == b->ancestor(middle)){
+            agrees = middle;
+        }else{
+            differs = middle;
+        }
+    }
+    return a->ancestor(agrees);
+}
+
+class BlockStore{
+protected:
+    typedef std::pair<const BlockNode*, std::string>    Key; // parent and contentKey
+
+    struct KeyHash{
+        size_t operator()(const Key &key)const{return std::hash<std::string>()(key.second) ^ (std::hash<const void*>()(key.first) * 31);};
+    };
+
+    std::unordered_map<Key, std::shared_ptr<const BlockNode>, KeyHash>  _blocks;
+    size_t                                      _pruneAt; // size that triggers the next prune
+    mutable std::mutex                          _lock;
+
+    static bool         sameBlock           (const Block &a, const Block &b);
+    // hash and publishers, miners that find the same hash (their first block) still get their own node
+    static std::string  contentKey          (const Block &block);
+    static Key          keyOf               (const BlockNode &node)                         {return Key(node.parent(), contentKey(node.block()));};
+    void                prune               (); // with _lock held
+
+public:
+    BlockStore                                  () : _pruneAt(4096)                             {};
+    BlockStore                                  (const BlockStore&) = delete;
+
+    // the node for block on top of parent (nullptr for a genesis block), the existing node if the same block was added there before
+    std::shared_ptr<const BlockNode> extend (const std::shared_ptr<const BlockNode> &parent, const Block &block);
+    // blocks in the index, blocks no chain holds any more are dropped as the store grows
+    size_t              size                ()const                                         {std::lock_guard<std::mutex> guard(_lock); return _blocks.size();};
+
+    BlockStore&         operator=           (const BlockStore&) = delete;
+};
+
+inline bool BlockStore::sameBlock(const Block &a, const Block &b){
+    return a.getIndex() == b.getIndex() && a.getHash() == b.getHash() && a.getPreviousHash() == b.getPreviousHash() && a.getPublishers() == b.getPublishers();
+}
+
+inline std::string BlockStore::contentKey(const Block &block){
+    std::string key = block.getHash();
+    for(const std::string &publisher : block.getPublishers()){
+        key += '\0';
+        key += publisher;
+    }
+    return key;
+}
+
+inline std::shared_ptr<const BlockNode> BlockStore::extend(const std::shared_ptr<const BlockNode> &parent, const Block &block){
+    Key key(parent.get(), contentKey(block));
+    std::lock_guard<std::mutex> guard(_lock);
+    auto existing = _blocks.find(key);
+    if(existing != _blocks.end() && sameBlock(existing->second->block(), block)){
+        return existing->second;
+    }
+    std::shared_ptr<const BlockNode> node = std::make_shared<BlockNode>(block, parent);
+    // a different block under a key already taken stays out of the index
+    if(existing == _blocks.end()){
+        _blocks.emplace(key, node);
+        if(_blocks.size() >= _pruneAt){
+            prune();
+            _pruneAt = std::max<size_t>(4096, _blocks.size() * 2);
+        }
+    }
+    return node;
+}
+
+// drops blocks only the index holds, a dropped block can free its parent so the walk continues up
+inline void BlockStore::prune(){
+    for(auto entry = _blocks.begin(); entry != _blocks.end();){
+        if(entry->second.use_count() != 1){
+            entry++;
+            continue;
+        }
+        std::shared_ptr<const BlockNode> node = std::move(entry->second);
+        entry = _blocks.erase(entry);
+        while(node != nullptr){
+            std::shared_ptr<const BlockNode> parent = node->parentHandle();
+            node.reset();
+            if(parent == nullptr){
+                break;
+            }
+            auto indexed = _blocks.find(keyOf(*parent));
+            bool inIndex = indexed != _blocks.end() && indexed->second == parent;
+            if(parent.use_count() != (inIndex ? 2 : 1)){
+                break;
+            }
+            if(inIndex){
+                if(indexed == entry){
+                    entry = _blocks.erase(indexed);
+                }else{
+                    _blocks.erase(indexed);
+                }
+            }
+            node = std::move(parent);
+        }
+    }
+}
+
+// every chain in the process builds on this store
+inline BlockStore& blockStore(){
+    static BlockStore store;
+    return store;
+}
+
+#endif /* BlockStore_hpp */
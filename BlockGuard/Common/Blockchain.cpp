@@ -5,51 +5,38 @@
 #include "Blockchain.hpp"
 Blockchain::Blockchain(bool init){
 	if (init) {
-		this->chain.push_back(std::make_unique<Block>(0,"-1_-1","genesisHash", std::set<string>{}));
+		this->tip = blockStore().extend(nullptr, Block(0,"-1_-1","genesisHash", std::set<string>{}));
 	}
 }
 
 int Blockchain::createBlock(int blockIndex, string prevHash, string blockHash, set<string> publishers) {
-	//inserting to the chain without any work
-	this->chain.push_back(std::make_unique<Block>(blockIndex,prevHash,blockHash, publishers));
+	//inserting to the chain without any work, a block another chain already has on this tip is shared
+	this->tip = blockStore().extend(tip, Block(blockIndex, std::move(prevHash), std::move(blockHash), std::move(publishers)));
 	return blockIndex;
 }
 
-
-Block Blockchain::getBlockAt(int index) {
-	return *chain[index];
+void Blockchain::truncate(int size) {
+	if (size <= 0) this->tip = nullptr;
+	else if (size < getChainSize()) this->tip = tip->ancestor(size - 1)->shared_from_this();
 }
 
-int Blockchain::getChainSize() const{
-	return static_cast<int>(this->chain.size());
-}
 
-
-string Blockchain::getLatestBlockHash() {
-	return this->chain[chain.size()-1]->getHash();
+const Block& Blockchain::getBlockAt(int index) const {
+	return tip->ancestor(index)->block();
 }
 
-std::ostream& operator<<(std::ostream& os, Blockchain& blockchain){
-	for(auto const& node: blockchain.chain) {
-		os << *node;
-	}
-	return os;
+int Blockchain::getChainSize() const{
+	return (tip == nullptr ? 0 : tip->height() + 1);
 }
 
-Blockchain& Blockchain::operator=(const Blockchain& rhs){
-	if(this == &rhs)
-		return *this;
-	chain.clear();
-	for (int i = 0; i < rhs.chain.size(); i++) {
-		chain.push_back(std::make_unique<Block>(*rhs.chain[i]));
-	}
-
-	return *this;
 
+string Blockchain::getLatestBlockHash() const {
+	return this->tip->block().getHash();
 }
 
-Blockchain::Blockchain(const Blockchain &rhs) {
-	for (int i = 0; i < rhs.chain.size(); i++) {
-		chain.push_back(std::make_unique<Block>(*rhs.chain[i]));
+std::ostream& operator<<(std::ostream& os, const Blockchain& blockchain){
+	for (int i = 0; i < blockchain.getChainSize(); i++) {
+		os << blockchain.getBlockAt(i);
 	}
+	return os;
 }
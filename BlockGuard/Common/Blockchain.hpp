@@ -10,28 +10,32 @@
 #include <vector>
 #include <memory>
 #include "Block.hpp"
+#include "BlockStore.hpp"
 using std::vector;
 using std::string;
 using std::unique_ptr;
 
+// A chain is a handle on its tip in the shared block store, copies share every block
 class Blockchain {
-	vector<unique_ptr<Block>> 					chain;
+	std::shared_ptr<const BlockNode> 			tip; // nullptr while the chain is empty
 
 public:
 	explicit Blockchain													(bool init);
 
 	int 								createBlock						(int , string , string , set<string> );
+	void 								truncate						(int size); // keeps the first size blocks
 
-	string 								getLatestBlockHash				();
+	string 								getLatestBlockHash				() const;
 	int 								getChainSize					() const;
 
-	Block 								getBlockAt						(int index);
+	const Block& 						getBlockAt						(int index) const; // O(log n) from the tip
+	const std::shared_ptr<const BlockNode>& getTip						() const						{ return tip; };
 
-	Blockchain& 						operator=						(const Blockchain&);
-	Blockchain															(const Blockchain&);
+	Blockchain& 						operator=						(const Blockchain&) = default;
+	Blockchain															(const Blockchain&) = default;
 	~Blockchain															() = default;
 
-	friend std::ostream &operator<<(std::ostream &os, Blockchain &blockchain);
+	friend std::ostream &operator<<(std::ostream &os, const Blockchain &blockchain);
 };
 
 
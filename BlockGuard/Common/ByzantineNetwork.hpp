@@ -193,8 +193,8 @@ void ByzantineNetwork<type_msg,peer_type>::shuffleByzantines(int shuffleCount){
 
     while (shuffled<shuffleCount && !byzantineIndex.empty() && !nonByzantineIndex.empty()){
         //find list of byzantineFlag peers
-        int byzantineShuffleIndex = static_cast<int>(rand() % byzantineIndex.size());
-        int nonByzantineShuffleIndex = static_cast<int>(rand() % nonByzantineIndex.size());
+        int byzantineShuffleIndex = static_cast<int>(Network<type_msg,peer_type>::random(SHUFFLE_STREAM)() % byzantineIndex.size());
+        int nonByzantineShuffleIndex = static_cast<int>(Network<type_msg,peer_type>::random(SHUFFLE_STREAM)() % nonByzantineIndex.size());
         Network<type_msg,peer_type>::_peers[byzantineIndex[byzantineShuffleIndex]]->makeCorrect();
         Network<type_msg,peer_type>::_peers[nonByzantineIndex[nonByzantineShuffleIndex]]->makeByzantine();
         shuffled++;
@@ -0,0 +1,105 @@
+//
+//  DeliveryQueue.hpp
+//  BlockGuard
+//
+//  Calendar queue of packets keyed by the absolute round they arrive in.
+//  A peer only pays for the rounds where something actually lands, an idle
+//  peer costs one comparison per round no matter how many channels it has.
+//
+
+#ifndef DeliveryQueue_hpp
+#define DeliveryQueue_hpp
+
+#include <map>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <utility>
+
+template<class item>
+class DeliveryQueue{
+protected:
+    typedef std::vector<item>           aBucket;
+    std::map<int, aBucket>              _calendar; // arrival round -> items that arrive in that round
+    int                                 _size;
+
+public:
+    DeliveryQueue                                           ()                                  {_size = 0;};
+    DeliveryQueue                                           (const DeliveryQueue<item> &rhs)    {_calendar = rhs._calendar; _size = rhs._size;};
+    ~DeliveryQueue                                          ()                                  {};
+
+    // getters
+    int                                 size                ()const                             {return _size;};
+    bool                                empty               ()const                             {return _size == 0;};
+    bool                                hasArrivals         (int round)const                    {return !_calendar.empty() && _calendar.begin()->first <= round;};
+    int                                 nextArrival         ()const                             {return _calendar.empty() ? -1 : _calendar.begin()->first;};
+    template<class predicate>
+    int                                 count               (predicate)const;
+
+    // mutators
+    void                                schedule            (int round, const item&);
+    void                                schedule            (int round, item&&);
+    // moves every item due by round into out, items landing in the same round are ordered with before
+    template<class compare>
+    void                                collect             (int round, std::deque<item> &out, compare before);
+    template<class predicate>
+    void                                removeIf            (predicate);
+    void                                clear               ()                                  {_calendar.clear(); _size = 0;};
+
+    DeliveryQueue&                      operator=           (const DeliveryQueue<item> &rhs)    {_calendar = rhs._calendar; _size = rhs._size; return *this;};
+};
+
+template<class item>
+void DeliveryQueue<item>::schedule(int round, const item &entry){
+    _calendar[round].push_back(entry);
+    _size++;
+}
+
+template<class item>
+void DeliveryQueue<item>::schedule(int round, item &&entry){
+    _calendar[round].push_back(std::move(entry));
+    _size++;
+}
+
+template<class item>
+template<class compare>
+void DeliveryQueue<item>::collect(int round, std::deque<item> &out, compare before){
+    while(!_calendar.empty() && _calendar.begin()->first <= round){
+        aBucket &bucket = _calendar.begin()->second;
+        std::stable_sort(bucket.begin(), bucket.end(), before);
+        for(int i = 0; i < bucket.size(); i++){
+            out.push_back(std::move(bucket[i]));
+        }
+        _size -= (int)bucket.size();
+        _calendar.erase(_calendar.begin());
+    }
+}
+
+template<class item>
+template<class predicate>
+int DeliveryQueue<item>::count(predicate matches)const{
+    int total = 0;
+    for(auto bucket = _calendar.begin(); bucket != _calendar.end(); bucket++){
+        total += (int)std::count_if(bucket->second.begin(), bucket->second.end(), matches);
+    }
+    return total;
+}
+
+template<class item>
+template<class predicate>
+void DeliveryQueue<item>::removeIf(predicate matches){
+    auto bucket = _calendar.begin();
+    while(bucket != _calendar.end()){
+        aBucket &entries = bucket->second;
+        auto last = std::remove_if(entries.begin(), entries.end(), matches);
+        _size -= (int)std::distance(last, entries.end());
+        entries.erase(last, entries.end());
+        if(entries.empty()){
+            _calendar.erase(bucket++);
+        }else{
+            bucket++;
+        }
+    }
+}
+
+#endif /* DeliveryQueue_hpp */
@@ -0,0 +1,90 @@
+//
+//  NameTable.hpp
+//  BlockGuard
+//
+//  Maps small integers back to the strings they stand for. Packets carry
+//  peer indices and label numbers instead of strings, the names are only
+//  looked up here when something is printed or compared by name.
+//
+
+#ifndef NameTable_hpp
+#define NameTable_hpp
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+
+class NameTable{
+protected:
+    std::deque<std::string>                         _names;
+    std::unordered_map<std::string, uint32_t>       _interned; // names handed out by intern
+    mutable std::mutex                              _lock;
+
+public:
+    NameTable                                       ()                                  {};
+    NameTable                                       (const NameTable&) = delete;
+
+    // always adds a new entry, used when two things may share a name (peers in different networks)
+    uint32_t                    append              (const std::string &name)           {std::lock_guard<std::mutex> guard(_lock); _names.push_back(name); return (uint32_t)_names.size() - 1;};
+    // returns the entry already holding name or adds one
+    uint32_t                    intern              (const std::string &name);
+    void                        rename              (uint32_t i, const std::string &name){std::lock_guard<std::mutex> guard(_lock); _names[i] = name;};
+    std::string                 name                (uint32_t i)const                   {std::lock_guard<std::mutex> guard(_lock); return i < _names.size() ? _names[i] : "";};
+    uint32_t                    size                ()const                             {std::lock_guard<std::mutex> guard(_lock); return (uint32_t)_names.size();};
+
+    NameTable&                  operator=           (const NameTable&) = delete;
+};
+
+inline uint32_t NameTable::intern(const std::string &name){
+    std::lock_guard<std::mutex> guard(_lock);
+    auto entry = _interned.find(name);
+    if(entry != _interned.end()){
+        return entry->second;
+    }
+    _names.push_back(name);
+    uint32_t i = (uint32_t)_names.size() - 1;
+    _interned[name] = i;
+    return i;
+}
+
+// peer index -> peer id, every peer appends itself when it is constructed
+inline NameTable& peerNames(){
+    static NameTable table;
+    return table;
+}
+
+// A peer carried as its index in peerNames(). Two ids compare by index, an id and a
+// string compare by name, and ids print as the name.
+struct PeerId{
+    static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    
+    uint32_t                    index = NONE;
+    
+    PeerId                                          ()                                  {};
+    explicit PeerId                                 (uint32_t i)                        {index = i;};
+    
+    std::string                 name                ()const                             {return index == NONE ? "" : peerNames().name(index);};
+    
+    bool                        operator==          (const PeerId &rhs)const            {return index == rhs.index;};
+    bool                        operator!=          (const PeerId &rhs)const            {return index != rhs.index;};
+    bool                        operator==          (const std::string &rhs)const       {return name() == rhs;};
+    bool                        operator!=          (const std::string &rhs)const       {return name() != rhs;};
+    bool                        operator==          (const char *rhs)const              {return name() == rhs;};
+    bool                        operator!=          (const char *rhs)const              {return name() != rhs;};
+};
+
+inline std::ostream& operator<<(std::ostream &out, const PeerId &id){
+    return out<< id.name();
+}
+
+// packet label number -> label, for protocols that name there packets with strings
+inline NameTable& packetLabels(){
+    static NameTable table;
+    return table;
+}
+
+#endif /* NameTable_hpp */
@@ -19,29 +19,63 @@
 #include <chrono>
 #include <ctime>
 #include <memory>
+#include <unordered_map>
+#include <numeric>
 #include "./../Common/Peer.hpp"
 #include "./../Common/DAG.hpp"
+#include "./../Common/ThreadPool.hpp"
+#include "./../Common/Topology.hpp"
+#include "./../Common/Random.hpp"
 
 static const std::string                POISSON = "POISSON";
 static const std::string                RANDOM  = "RANDOM";
 static const std::string                ONE     = "ONE";
+// topologies
+static const std::string                FULL_MESH       = "FULL_MESH";
+static const std::string                K_REGULAR       = "K_REGULAR";
+static const std::string                ERDOS_RENYI     = "ERDOS_RENYI";
+static const std::string                WATTS_STROGATZ  = "WATTS_STROGATZ";
+static const std::string                BARABASI_ALBERT = "BARABASI_ALBERT";
+static const std::string                EDGE_LIST       = "EDGE_LIST";
 template<class type_msg, class peer_type>
 class Network{
 protected:
 
     std::vector<Peer<type_msg>*>        _peers;
+    std::unordered_map<std::string,int> _position; // peer id -> position in _peers
     int                                 _avgDelay;
     int                                 _maxDelay;
     int                                 _minDelay;
     std::string                         _distribution;
+    std::string                         _topology;
+    int                                 _topologyDegree; // k for k-regular and Watts-Strogatz, m for Barabasi-Albert
+    double                              _topologyProbability; // p for Erdos-Renyi, beta for Watts-Strogatz
+    std::vector<TopologyEdge>           _edgeList;
 
     std::ostream                         *_log;
 
+    // randomness, the network's own draws (ids, edges, shuffles) use streams keyed by _round
+    uint32_t                            _streamSpace;
+    int                                 _round; // number of calls to receive
+    RandomStreams                       _random;
+
+    // metrics
+    std::vector<int>                    _activeCounts; // peers stepped in each call to preformComputation
+
+    // parallel stepping, null when the network steps serially
+    typedef typename Peer<type_msg>::Dispatch aDispatch;
+    std::unique_ptr<ThreadPool>         _pool;
+    // _outboxes[worker][owner], worker routes a contiguous run of peers and owner is the receiver's index mod workers
+    std::vector<std::vector<std::vector<aDispatch> > > _outboxes;
+
     std::string                         createId            ();
     bool                                idTaken             (std::string);
     std::string                         getUniqueId         ();
     void                                addEdges            (Peer<type_msg>*);
+    void                                addEdges            (const std::vector<TopologyEdge>&, int first); // first is the position of node 0
+    std::vector<TopologyEdge>           buildTopology       (int); // edges of the sparse topologies, not used for the full mesh
     int                                 getDelay            ();
+    int                                 getEdgeDelay        (); // getDelay with in [min, max]
 	peer_type*							getPeerById			(std::string);
 
 public:
@@ -57,7 +91,21 @@ public:
     void                                setToRandom         ()                                              {_distribution = RANDOM;};
     void                                setToPoisson        ()                                              {_distribution = POISSON;};
     void                                setToOne            ()                                              {_distribution = ONE;};
+    // topology initNetwork wires the peers as, full mesh by default
+    void                                setToFullMesh       ()                                              {_topology = FULL_MESH;};
+    void                                setToKRegular       (int k)                                         {_topology = K_REGULAR; _topologyDegree = k;};
+    void                                setToErdosRenyi     (double p)                                      {_topology = ERDOS_RENYI; _topologyProbability = p;};
+    void                                setToWattsStrogatz  (int k, double beta)                            {_topology = WATTS_STROGATZ; _topologyDegree = k; _topologyProbability = beta;};
+    void                                setToBarabasiAlbert (int m)                                         {_topology = BARABASI_ALBERT; _topologyDegree = m;};
+    void                                setToEdgeList       (const std::vector<TopologyEdge> &edges)        {_topology = EDGE_LIST; _edgeList = edges;};
+    void                                setToEdgeList       (std::istream &in)                              {setToEdgeList(readEdgeList(in));};
     void                                setLog              (std::ostream&);
+    // steps the peers on n threads, 1 (the default) steps them serially. peer types that do not
+    // set PARALLEL_STEP are always stepped serially
+    void                                setThreads          (int);
+    // networks get a new space each so two networks in one run draw different numbers,
+    // giving two networks the same space (and seed) makes them draw the same ones
+    void                                setStreamSpace      (uint32_t);
 
     // getters
     int                                 size                ()const                                         {return (int)_peers.size();};
@@ -65,13 +113,28 @@ public:
     int                                 avgDelay            ()const                                         {return _avgDelay;};
     int                                 minDelay            ()const                                         {return _minDelay;};
     std::string                         distribution        ()const                                         {return _distribution;};
+    std::string                         topology            ()const                                         {return _topology;};
+    int                                 threads             ()const                                         {return _pool == nullptr ? 1 : _pool->size();};
+    uint32_t                            streamSpace         ()const                                         {return _streamSpace;};
+    int                                 round               ()const                                         {return _round;};
+    // earliest round any peer has something to do in, NEVER when the network is quiet for good
+    int                                 nextEvent           ()const;
+    // size of the active set, peers that were stepped because they had work, in the last round and in every round
+    int                                 activeCount         ()const                                         {return _activeCounts.empty() ? 0 : _activeCounts.back();};
+    std::vector<int>                    activeCounts        ()const                                         {return _activeCounts;};
+    // this round's network level stream for purpose (SHUFFLE_STREAM, COMMITTEE_STREAM, ...)
+    RandomStream&                       random              (uint32_t purpose)                              {return _random.at(_streamSpace, NETWORK_STREAM, _round, purpose);};
 
 
     //mutators
     void                                receive             ();
     void                                preformComputation  ();
     void                                transmit            ();
-    void                                makeRequest         (int i)                                         {_peers[i]->makeRequest();};
+    // steps the network until maxRounds more rounds have passed, rounds where no packet arrives and no
+    // peer wakes up are skipped by moving every clock forward. returns the number of rounds stepped
+    int                                 run                 (int maxRounds);
+    void                                fastForward         (int rounds);
+    void                                makeRequest         (int i)                                         {_peers[i]->makeRequest(); _peers[i]->wake();};
 	void                                shuffleByzantines   (int);
 
 	// logging and debugging
@@ -83,7 +146,7 @@ public:
     peer_type*                          operator[]          (int);
     const peer_type*                    operator[]          (int)const;
     friend std::ostream&                operator<<          (std::ostream &out, const Network &system)      {return system.printTo(out);};
-	void 								makeRequest			(Peer<type_msg> * peer)				            { peer->makeRequest(); }
+	void 								makeRequest			(Peer<type_msg> * peer)				            { peer->makeRequest(); peer->wake(); }
 	void 								buildInitialDAG		();
 	std::vector<peer_type *>			setPeersForConsensusDAG(Peer<type_msg> *,int);
 	int									pickSecurityLevel	(int);
@@ -93,11 +156,21 @@ public:
 template<class type_msg, class peer_type>
 Network<type_msg,peer_type>::Network(){
     _peers = std::vector<Peer<type_msg>*>();
+    _position = std::unordered_map<std::string,int>();
     _avgDelay = 1;
     _maxDelay = 1;
     _minDelay = 1;
     _distribution = RANDOM;
+    _topology = FULL_MESH;
+    _topologyDegree = 0;
+    _topologyProbability = 0;
+    _edgeList = std::vector<TopologyEdge>();
     _log = &std::cout;
+    _streamSpace = newStreamSpace();
+    _round = 0;
+    _random = RandomStreams();
+    _activeCounts = std::vector<int>();
+    _pool = nullptr;
 }
 
 template<class type_msg, class peer_type>
@@ -114,11 +187,21 @@ Network<type_msg,peer_type>::Network(const Network<type_msg,peer_type> &rhs){
     for(int i = 0; i < rhs._peers.size(); i++){
         _peers.push_back(new peer_type(*dynamic_cast<peer_type*>(rhs._peers[i])));
     }
+    _position = rhs._position;
     _avgDelay = rhs._avgDelay;
     _maxDelay = rhs._maxDelay;
     _minDelay = rhs._minDelay;
     _distribution = rhs._distribution;
+    _topology = rhs._topology;
+    _topologyDegree = rhs._topologyDegree;
+    _topologyProbability = rhs._topologyProbability;
+    _edgeList = rhs._edgeList;
     _log = rhs._log;
+    _streamSpace = rhs._streamSpace;
+    _round = rhs._round;
+    _random = rhs._random;
+    _activeCounts = rhs._activeCounts;
+    setThreads(rhs.threads());
 }
 
 template<class type_msg, class peer_type>
@@ -137,6 +220,32 @@ void Network<type_msg,peer_type>::setLog(std::ostream &out){
     }
 }
 
+template<class type_msg, class peer_type>
+void Network<type_msg,peer_type>::setThreads(int threads){
+    if(threads > 1 && !peer_type::PARALLEL_STEP){
+        std::cerr<< "ERROR: these peers touch there neighbors in a step, stepping them on one thread"<< std::endl;
+        threads = 1;
+    }
+    if(threads <= 1){
+        _pool = nullptr;
+        _outboxes.clear();
+        return;
+    }
+    if(threads == this->threads()){
+        return;
+    }
+    _pool = std::unique_ptr<ThreadPool>(new ThreadPool(threads));
+    _outboxes = std::vector<std::vector<std::vector<aDispatch> > >(threads, std::vector<std::vector<aDispatch> >(threads));
+}
+
+template<class type_msg, class peer_type>
+void Network<type_msg,peer_type>::setStreamSpace(uint32_t space){
+    _streamSpace = space;
+    for(int i = 0; i < _peers.size(); i++){
+        _peers[i]->setRandomStream(_streamSpace, i);
+    }
+}
+
 template<class type_msg, class peer_type>
 std::string Network<type_msg,peer_type>::createId(){
     char firstPos = '*';
@@ -147,11 +256,11 @@ std::string Network<type_msg,peer_type>::createId(){
 
     std::uniform_int_distribution<int> uniformDist(0,25);
     // add 'A' to shift char into rnage of upper case letters
-    firstPos = uniformDist(RANDOM_GENERATOR) + 'A';
-    secondPos = uniformDist(RANDOM_GENERATOR) + 'A';
-    thirdPos = uniformDist(RANDOM_GENERATOR) + 'A';
-    fourthPos = uniformDist(RANDOM_GENERATOR) + 'A';
-    fifthPos = uniformDist(RANDOM_GENERATOR) + 'A';
+    firstPos = uniformDist(random(ID_STREAM)) + 'A';
+    secondPos = uniformDist(random(ID_STREAM)) + 'A';
+    thirdPos = uniformDist(random(ID_STREAM)) + 'A';
+    fourthPos = uniformDist(random(ID_STREAM)) + 'A';
+    fifthPos = uniformDist(random(ID_STREAM)) + 'A';
 
     std::string id = "";
     id = id + firstPos + secondPos + thirdPos + fourthPos + fifthPos;
@@ -160,12 +269,7 @@ std::string Network<type_msg,peer_type>::createId(){
 
 template<class type_msg, class peer_type>
 bool Network<type_msg,peer_type>::idTaken(std::string id){
-    for(int i = 0; i < _peers.size(); i++){
-        if(_peers[i]->id() == id){
-            return true;
-        }
-    }
-    return false;
+    return _position.find(id) != _position.end();
 }
 
 template<class type_msg, class peer_type>
@@ -183,12 +287,8 @@ template<class type_msg, class peer_type>
 void Network<type_msg,peer_type>::addEdges(Peer<type_msg> *peer){
     for(int i = 0; i < _peers.size(); i++){
         if(_peers[i]->id() != peer->id()){
-            if(!_peers[i]->isNeighbor(peer->id())){
-                int delay = getDelay();
-                // guard agenst 0 and negative numbers
-                while(delay < 1 || delay > _maxDelay || delay < _minDelay){
-                    delay = getDelay();
-                }
+            if(!_peers[i]->isNeighbor(peer->index())){
+                int delay = getEdgeDelay();
                 peer->addNeighbor(*_peers[i], delay);
                 _peers[i]->addNeighbor(*peer,delay);
             }
@@ -196,15 +296,63 @@ void Network<type_msg,peer_type>::addEdges(Peer<type_msg> *peer){
     }
 }
 
+template<class type_msg, class peer_type>
+void Network<type_msg,peer_type>::addEdges(const std::vector<TopologyEdge> &edges, int first){
+    for(int i = 0; i < edges.size(); i++){
+        int from = first + edges[i].from;
+        int to = first + edges[i].to;
+        if(from >= _peers.size() || to >= _peers.size() || from == to){
+            std::cerr<< "ERROR: edge "<< edges[i].from<< " "<< edges[i].to<< " is not between two peers"<< std::endl;
+            continue;
+        }
+        if(_peers[from]->isNeighbor(_peers[to]->index())){
+            continue;
+        }
+        int delay = edges[i].delay == -1 ? getEdgeDelay() : edges[i].delay;
+        _peers[from]->addNeighbor(*_peers[to], delay);
+        _peers[to]->addNeighbor(*_peers[from], delay);
+    }
+}
+
+template<class type_msg, class peer_type>
+std::vector<TopologyEdge> Network<type_msg,peer_type>::buildTopology(int numberOfPeers){
+    if(_topology == K_REGULAR){
+        return kRegularTopology(numberOfPeers, _topologyDegree, random(TOPOLOGY_STREAM));
+    }
+    if(_topology == ERDOS_RENYI){
+        return erdosRenyiTopology(numberOfPeers, _topologyProbability, random(TOPOLOGY_STREAM));
+    }
+    if(_topology == WATTS_STROGATZ){
+        return wattsStrogatzTopology(numberOfPeers, _topologyDegree, _topologyProbability, random(TOPOLOGY_STREAM));
+    }
+    if(_topology == BARABASI_ALBERT){
+        return barabasiAlbertTopology(numberOfPeers, _topologyDegree, random(TOPOLOGY_STREAM));
+    }
+    if(_topology == EDGE_LIST){
+        return _edgeList;
+    }
+    return std::vector<TopologyEdge>();
+}
+
+template<class type_msg, class peer_type>
+int Network<type_msg,peer_type>::getEdgeDelay(){
+    int delay = getDelay();
+    // guard agenst 0 and negative numbers
+    while(delay < 1 || delay > _maxDelay || delay < _minDelay){
+        delay = getDelay();
+    }
+    return delay;
+}
+
 template<class type_msg, class peer_type>
 int Network<type_msg,peer_type>::getDelay(){
     if(_distribution == RANDOM){
         std::uniform_int_distribution<int> randomDistribution(_minDelay,_maxDelay);
-        return randomDistribution(RANDOM_GENERATOR);
+        return randomDistribution(random(TOPOLOGY_STREAM));
     }
     if(_distribution == POISSON){
         std::poisson_distribution<int> poissonDistribution(_avgDelay);
-        return poissonDistribution(RANDOM_GENERATOR);
+        return poissonDistribution(random(TOPOLOGY_STREAM));
     }
     if(_distribution == ONE){
         return 1;
@@ -214,41 +362,161 @@ int Network<type_msg,peer_type>::getDelay(){
 
 template<class type_msg, class peer_type>
 void Network<type_msg,peer_type>::initNetwork(int numberOfPeers){
+    std::vector<std::string> ids = std::vector<std::string>();
     for(int i = 0; i < numberOfPeers; i++){
-        _peers.push_back(new peer_type(getUniqueId()));
+        std::string id = getUniqueId();
+        _position[id] = (int)_peers.size() + i;
+        ids.push_back(id);
     }
-    for(int i = 0; i < _peers.size(); i++){
-        addEdges(_peers[i]);
+    // construct the peers in id order so they get consecutive indices that sort the same way there ids do
+    std::vector<std::string> byId = ids;
+    std::sort(byId.begin(), byId.end());
+    std::map<std::string, peer_type*> built = std::map<std::string, peer_type*>();
+    for(int i = 0; i < byId.size(); i++){
+        built[byId[i]] = new peer_type(byId[i]);
+    }
+    int first = (int)_peers.size();
+    for(int i = 0; i < ids.size(); i++){
+        _peers.push_back(built[ids[i]]);
+        _peers.back()->setRandomStream(_streamSpace, first + i);
+    }
+    if(_topology == FULL_MESH){
+        for(int i = 0; i < _peers.size(); i++){
+            addEdges(_peers[i]);
+        }
+    }else{
+        addEdges(buildTopology(numberOfPeers), first);
     }
 }
 
 template<class type_msg, class peer_type>
 void Network<type_msg,peer_type>::receive(){
-    for(int i = 0; i < _peers.size(); i++){
-        _peers[i]->receive();
+    _round++;
+    if(_pool == nullptr){
+        for(int i = 0; i < _peers.size(); i++){
+            _peers[i]->receive();
+        }
+        return;
     }
+    // a peer only moves its own in flight packets into its own in stream
+    _pool->parallelFor((int)_peers.size(), [this](int begin, int end, int worker){
+        for(int i = begin; i < end; i++){
+            _peers[i]->receive();
+        }
+    });
 }
 
 template<class type_msg, class peer_type>
 void Network<type_msg,peer_type>::preformComputation(){
-    for(int i = 0; i < _peers.size(); i++){
-        _peers[i]->preformComputation();
+    // only peers with work are stepped, an idle peer costs the check in due
+    if(_pool == nullptr){
+        int active = 0;
+        for(int i = 0; i < _peers.size(); i++){
+            if(_peers[i]->due()){
+                _peers[i]->step();
+                active++;
+            }
+        }
+        _activeCounts.push_back(active);
+        return;
     }
+    std::vector<int> active(_pool->size(), 0);
+    _pool->parallelFor((int)_peers.size(), [this, &active](int begin, int end, int worker){
+        for(int i = begin; i < end; i++){
+            if(_peers[i]->due()){
+                _peers[i]->step();
+                active[worker]++;
+            }
+        }
+    });
+    _activeCounts.push_back(std::accumulate(active.begin(), active.end(), 0));
 }
 
 template<class type_msg, class peer_type>
 void Network<type_msg,peer_type>::transmit(){
+    if(_pool == nullptr){
+        for(int i = 0; i < _peers.size(); i++){
+            _peers[i]->transmit();
+        }
+        return;
+    }
+    // each worker routes a contiguous run of peers and sorts the packets by which worker owns the receiver
+    int workers = (int)_outboxes.size();
+    _pool->parallelFor((int)_peers.size(), [this, workers](int begin, int end, int worker){
+        std::vector<aDispatch> routed;
+        for(int i = begin; i < end; i++){
+            _peers[i]->route(routed);
+        }
+        for(int i = 0; i < routed.size(); i++){
+            _outboxes[worker][routed[i].to->index() % workers].push_back(std::move(routed[i]));
+        }
+    });
+    // then each owner writes only its own receivers, reading the senders' outboxes in worker order
+    // so every channel gets its packets in the order the serial loop above sends them
+    _pool->run([this, workers](int owner){
+        for(int worker = 0; worker < workers; worker++){
+            std::vector<aDispatch> &outbox = _outboxes[worker][owner];
+            for(int i = 0; i < outbox.size(); i++){
+                Peer<type_msg>::dispatch(outbox[i]);
+            }
+            outbox.clear();
+        }
+    });
+}
+
+template<class type_msg, class peer_type>
+int Network<type_msg,peer_type>::nextEvent()const{
+    if(_pool == nullptr){
+        int next = NEVER;
+        for(int i = 0; i < _peers.size(); i++){
+            next = std::min(next, _peers[i]->nextEvent());
+        }
+        return next;
+    }
+    std::vector<int> next(_pool->size(), NEVER);
+    _pool->parallelFor((int)_peers.size(), [this, &next](int begin, int end, int worker){
+        for(int i = begin; i < end; i++){
+            next[worker] = std::min(next[worker], _peers[i]->nextEvent());
+        }
+    });
+    return *std::min_element(next.begin(), next.end());
+}
+
+template<class type_msg, class peer_type>
+void Network<type_msg,peer_type>::fastForward(int rounds){
+    if(rounds <= 0){
+        return;
+    }
+    _round += rounds;
     for(int i = 0; i < _peers.size(); i++){
-        _peers[i]->transmit();
+        _peers[i]->fastForward(rounds);
     }
 }
 
+template<class type_msg, class peer_type>
+int Network<type_msg,peer_type>::run(int maxRounds){
+    int last = _round + maxRounds;
+    int stepped = 0;
+    while(_round < last){
+        receive();
+        preformComputation();
+        transmit();
+        stepped++;
+        // clocks stop one short of the next event so the next receive lands on it
+        int next = nextEvent();
+        if(next > _round + 1){
+            fastForward(std::min(next - 1, last) - _round);
+        }
+    }
+    return stepped;
+}
+
 template<class type_msg, class peer_type>
 std::ostream& Network<type_msg,peer_type>::printTo(std::ostream &out)const{
     out<< "--- NETWROK SETUP ---"<< std::endl<< std::endl;
     out<< std::left;
-    out<< '\t'<< std::setw(LOG_WIDTH)<< "Number of Peers"<< std::setw(LOG_WIDTH)<< "Distribution"<< std::setw(LOG_WIDTH)<< "Min Delay"<< std::setw(LOG_WIDTH)<< "Average Delay"<< std::setw(LOG_WIDTH)<< "Max Delay"<< std::endl;
-    out<< '\t'<< std::setw(LOG_WIDTH)<< _peers.size()<< std::setw(LOG_WIDTH)<< _distribution<< std::setw(LOG_WIDTH)<< _minDelay<< std::setw(LOG_WIDTH)<< _avgDelay<< std::setw(LOG_WIDTH)<< _maxDelay<< std::endl;
+    out<< '\t'<< std::setw(LOG_WIDTH)<< "Number of Peers"<< std::setw(LOG_WIDTH)<< "Distribution"<< std::setw(LOG_WIDTH)<< "Min Delay"<< std::setw(LOG_WIDTH)<< "Average Delay"<< std::setw(LOG_WIDTH)<< "Max Delay"<< std::setw(LOG_WIDTH)<< "Topology"<< std::endl;
+    out<< '\t'<< std::setw(LOG_WIDTH)<< _peers.size()<< std::setw(LOG_WIDTH)<< _distribution<< std::setw(LOG_WIDTH)<< _minDelay<< std::setw(LOG_WIDTH)<< _avgDelay<< std::setw(LOG_WIDTH)<< _maxDelay<< std::setw(LOG_WIDTH)<< _topology<< std::endl;
 
     for(int i = 0; i < _peers.size(); i++){
         peer_type *p = dynamic_cast<peer_type*>(_peers[i]);
@@ -272,11 +540,21 @@ Network<type_msg, peer_type>& Network<type_msg,peer_type>::operator=(const Netwo
     for(int i = 0; i < rhs._peers.size(); i++){
         _peers.push_back(new peer_type(*dynamic_cast<peer_type*>(rhs._peers[i])));
     }
+    _position = rhs._position;
 
     _avgDelay = rhs._avgDelay;
     _maxDelay = rhs._maxDelay;
     _minDelay = rhs._minDelay;
     _distribution = rhs._distribution;
+    _topology = rhs._topology;
+    _topologyDegree = rhs._topologyDegree;
+    _topologyProbability = rhs._topologyProbability;
+    _edgeList = rhs._edgeList;
+    _streamSpace = rhs._streamSpace;
+    _round = rhs._round;
+    _random = rhs._random;
+    _activeCounts = rhs._activeCounts;
+    setThreads(rhs.threads());
 
     return *this;
 }
@@ -293,11 +571,10 @@ const peer_type* Network<type_msg,peer_type>::operator[](int i)const{
 
 template<class type_msg, class peer_type>
 peer_type* Network<type_msg,peer_type>::getPeerById(std::string id){
-	for(int i = 0; i<_peers.size(); i++){
-		if(_peers[i]->id() ==  id)
-			return dynamic_cast<peer_type*>(_peers[i]);
-	}
-	return nullptr;
+	auto position = _position.find(id);
+	if(position == _position.end())
+		return nullptr;
+	return dynamic_cast<peer_type*>(_peers[position->second]);
 }
 
 std::string sha256(const std::string& str);
@@ -399,7 +676,7 @@ std::vector<peer_type *> Network<type_msg,peer_type>::setPeersForConsensusDAG(Pe
 				std::cerr<<"Not enough peers to form a committee"<<std::endl;
 				return {};
 			}
-			int randIndex = rand() % sortedDAG.size();
+			int randIndex = random(COMMITTEE_STREAM)() % sortedDAG.size();
 			std::string peerId = sortedDAG[randIndex];
 			//random value
 			if(std::find(chosen.begin(), chosen.end(), peerId) !=  chosen.end()) {
@@ -461,8 +738,8 @@ void Network<type_msg,peer_type>::shuffleByzantines(int shuffleCount){
 	}
 	while (shuffled<shuffleCount){
 		//find list of byzantineFlag peers
-		int byzantineShuffleIndex = static_cast<int>(rand() % byzantineIndex.size());
-		int nonByzantineShuffleIndex = static_cast<int>(rand() % nonByzantineIndex.size());
+		int byzantineShuffleIndex = static_cast<int>(random(SHUFFLE_STREAM)() % byzantineIndex.size());
+		int nonByzantineShuffleIndex = static_cast<int>(random(SHUFFLE_STREAM)() % nonByzantineIndex.size());
 		_peers[byzantineIndex[byzantineShuffleIndex]]->setByzantineFlag(false);
 		_peers[nonByzantineIndex[nonByzantineShuffleIndex]]->setByzantineFlag(true);
 		byzantineIndex.erase(byzantineIndex.begin ()+byzantineShuffleIndex);
@@ -478,10 +755,10 @@ template<class type_msg, class peer_type>
 int Network<type_msg, peer_type>::pickSecurityLevel(int numberOfPeers){
 	std::uniform_int_distribution<int> coin(0,1);
 	int trails = 0;
-	int heads = coin(RANDOM_GENERATOR);
+	int heads = coin(random(COMMITTEE_STREAM));
 	while(!heads){
 		trails++;
-		heads = coin(RANDOM_GENERATOR);
+		heads = coin(random(COMMITTEE_STREAM));
 	}
 	switch (trails) {
 		case 0: return numberOfPeers / 16;
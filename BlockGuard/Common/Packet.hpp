@@ -13,12 +13,19 @@
 #include <string>
 #include <ctime>
 #include <random>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "NameTable.hpp"
 
 //
 //Base Message Class
 //
 
-static std::default_random_engine RANDOM_GENERATOR = std::default_random_engine((int)time(nullptr));
+// packets that are not addressed to or from a peer yet
+static const uint32_t NO_PEER = UINT32_MAX;
+// set on a packet id that is the number of an interned string label
+static const uint32_t LABEL_BIT = 0x80000000u;
 
 template<class content>
 class Packet{
@@ -27,33 +34,46 @@ private:
     Packet(){};
     
 protected:
-    std::string                 _id; // message id
-    std::string                 _targetId; // traget node id
-    std::string                 _sourceId; // source node id
+    // fixed 16 byte header, endpoints are peer indices and names are only rendered for logging
+    uint32_t                    _source; // source node index
+    uint32_t                    _target; // traget node index
+    uint32_t                    _seq; // message id, a number or a label (LABEL_BIT set)
+    int32_t                     _delay; // delay of the message
     
-    content                     _body;
-    
-    int                         _delay; // delay of the message
+    // the body is immutable once set and shared by every copy of the packet, so a broadcast
+    // stores the message once and each receiver only gets its own header
+    std::shared_ptr<const content> _body;
+
+    // what getMessage reads before a body is set
+    static const content& emptyBody(){static const content empty = content(); return empty;};
     
 public:
-    Packet                      (std::string id);
-    Packet                      (std::string id, std::string to, std::string from);
+    Packet                      (uint32_t seq, uint32_t to = NO_PEER, uint32_t from = NO_PEER);
+    Packet                      (const std::string &label, uint32_t to = NO_PEER, uint32_t from = NO_PEER);
     Packet                      (const Packet<content>&);
+    Packet                      (Packet<content>&&);
     ~Packet                     ();
     
     // setters
-    void        setSource       (std::string s){_sourceId = s;};
-    void        setTarget       (std::string t){_targetId = t;};
-    void        setDelay        (int delayMax, int delayMin = 0);
-    void        setBody         (const content c){_body = c;};
+    void        setSource       (uint32_t s){_source = s;};
+    void        setTarget       (uint32_t t){_target = t;};
+    template<class engine>
+    void        setDelay        (engine&, int delayMax, int delayMin = 0);
+    void        setBody         (const content &c){_body = std::make_shared<const content>(c);};
+    void        setBody         (content &&c){_body = std::make_shared<const content>(std::move(c));};
     
     // getters
-    std::string id              (){return _id;};
-    std::string targetId        (){return _targetId;};
-    std::string sourceId        (){return _sourceId;};
-    bool        hasArrived      (){return !(bool)(_delay);};
-    content     getMessage      (){return _body;};
-    int         getDelay        (){return _delay;};
+    uint32_t    source          ()const{return _source;};
+    uint32_t    target          ()const{return _target;};
+    uint32_t    seq             ()const{return _seq;};
+    std::string id              ()const{return _seq & LABEL_BIT ? packetLabels().name(_seq & ~LABEL_BIT) : std::to_string(_seq);};
+    std::string targetId        ()const{return peerNames().name(_target);};
+    std::string sourceId        ()const{return peerNames().name(_source);};
+    bool        hasArrived      ()const{return !(bool)(_delay);};
+    // reference into the shared body, copy it to keep it past the packet or to change it
+    const content& getMessage   ()const{return _body ? *_body : emptyBody();};
+    bool        sharesBody      (const Packet<content> &rhs)const{return _body && _body == rhs._body;};
+    int         getDelay        ()const{return _delay;};
     
     // mutators
     void        moveForward     (){_delay--;};
@@ -61,62 +81,83 @@ public:
     //void
     
     Packet&     operator=       (const Packet<content> &rhs);
+    Packet&     operator=       (Packet<content> &&rhs);
     bool        operator==      (const Packet<content> &rhs);
     bool        operator!=      (const Packet<content> &rhs);
     
 };
 
 template<class content>
-Packet<content>::Packet(std::string id){
-    _id = id;
-    _sourceId = "";
-    _targetId = "";
-    _body = content();
+Packet<content>::Packet(uint32_t seq, uint32_t to, uint32_t from){
+    _source = from;
+    _target = to;
+    _seq = seq;
     _delay = 0;
+    _body = nullptr;
 }
 
 template<class content>
-Packet<content>::Packet(std::string id, std::string to ,std::string from){
-    _id = id;
-    _sourceId = from;
-    _targetId = to;
-    _body = content();
+Packet<content>::Packet(const std::string &label, uint32_t to, uint32_t from){
+    _source = from;
+    _target = to;
+    _seq = packetLabels().intern(label) | LABEL_BIT;
     _delay = 0;
+    _body = nullptr;
 }
 
 template<class content>
 Packet<content>::Packet(const Packet<content>& rhs){
-    _id = rhs._id;
-    _targetId = rhs._targetId;
-    _sourceId = rhs._sourceId;
+    _source = rhs._source;
+    _target = rhs._target;
+    _seq = rhs._seq;
+    _delay = rhs._delay;
     _body = rhs._body;
+}
+
+template<class content>
+Packet<content>::Packet(Packet<content>&& rhs){
+    _source = rhs._source;
+    _target = rhs._target;
+    _seq = rhs._seq;
     _delay = rhs._delay;
+    _body = std::move(rhs._body);
 }
 
 template<class content>
 Packet<content>::~Packet(){
-    // no memory allocated so nothing to do
+    // the body is released when the last packet sharing it goes
 }
 
 template <class content>
-void Packet<content>::setDelay(int maxDelay, int minDelay){
+template <class engine>
+void Packet<content>::setDelay(engine &generator, int maxDelay, int minDelay){
     std::uniform_int_distribution<int> uniformDist(minDelay,(maxDelay - 1));
-    _delay = uniformDist(RANDOM_GENERATOR); // max is not included so delay 1 is next round delay 2 is one round waiting and then receve in the following round
+    _delay = uniformDist(generator); // max is not included so delay 1 is next round delay 2 is one round waiting and then receve in the following round
 }
 
 template<class content>
 Packet<content>& Packet<content>::operator=(const Packet<content> &rhs){
-    _id = rhs._id;
-    _targetId = rhs._targetId;
-    _sourceId = rhs._sourceId;
+    _source = rhs._source;
+    _target = rhs._target;
+    _seq = rhs._seq;
+    _delay = rhs._delay;
     _body = rhs._body;
+    return *this;
+}
+
+template<class content>
+Packet<content>& Packet<content>::operator=(Packet<content> &&rhs){
+    _source = rhs._source;
+    _target = rhs._target;
+    _seq = rhs._seq;
     _delay = rhs._delay;
+    _body = std::move(rhs._body);
     return *this;
 }
 
 template<class content>
 bool Packet<content>::operator==(const Packet<content> &rhs){
-    return _id == rhs._id;
+    return _seq == rhs._seq;
 }
 
 template<class content>
@@ -17,10 +17,17 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include "Packet.hpp"
+#include "NameTable.hpp"
+#include "DeliveryQueue.hpp"
+#include "Random.hpp"
 
 // var used for column width in loggin
 static const int LOG_WIDTH = 27;
+// round returned by nextWakeup when a peer has no timer armed
+static const int NEVER = std::numeric_limits<int>::max();
 
 //
 // Base Peer class
@@ -28,66 +35,122 @@ static const int LOG_WIDTH = 27;
 template <class message>
 class Peer{
 protected:
-    std::string                             _id;
+    std::string                             _id; // display name, peers are addressed by _index
+    uint32_t                                _index; // entry in peerNames(), peers constructed one after another get consecutive ones
     bool                                    _byzantine;
 	bool									_busy;
     int                                     _clock;
+    int                                     _lastStep; // clock of the last round preformComputation ran in
+    bool                                    _woken; // step this peer next round even if nothing arrives
     
-    // type abbreviations
-    typedef std::deque<Packet<message> >    aChannel;
-    typedef std::string                     peerId;
-    std::map<peerId,aChannel>               _channels;// list of chanels between this peer and others
-    std::map<peerId,int>                    _channelDelays;// list of channels and there delays
-    std::map<std::string, Peer<message>* >  _neighbors; // peers this peer has a link to
+    // this peer's row of the adjacency, parallel arrays sorted by neighbor index
+    std::vector<Peer<message>*>             _links;
+    std::vector<uint32_t>                   _linkIndex;
+    std::vector<int>                        _linkDelay;// max delay of the channel to each neighbor
+    std::vector<int>                        _channelTails;// round the last packet on each incoming channel arrives in
+    bool                                    _denseRow;// links are every index in [front, back] but this peer
+    DeliveryQueue<Packet<message> >         _inFlight;// packets sent to this peer keyed by the round they arrive in
+    std::map<std::string, Peer<message>* >  _neighbors; // peers this peer has a link to, by id for the protocols
     std::deque<Packet<message> >            _inStream;// messages that have arrived at this peer
     std::deque<Packet<message> >            _outStream;// messages waiting to be sent by this peer
     
+    // randomness, streams are keyed by (space, peer, _clock) so draws do not depend on thread or peer order
+    RandomStreams                           _random;
+    uint32_t                                _streamSpace;
+    uint32_t                                _streamPeer;
+    
     // metrics
     int                                     _numberOfMessagesSent;
     
     // logging
     std::ostream                            *_log;
     bool                                    _printNeighborhood;
+
+    // position of a neighbor in the link arrays, -1 if index is not a neighbor
+    int                                     slotOf              (uint32_t index)const;
+    void                                    updateDenseRow      ();
     
 public:
+    // a packet that has left its sender, resolved to the peer it lands on (to == from for self loops)
+    struct Dispatch{
+        Peer<message>                       *from;
+        Peer<message>                       *to;
+        Packet<message>                     packet;
+    };
+    // true if receive and preformComputation only touch this peer (and state shared under a lock), a network
+    // only steps peers on several threads if it is. peers that read or write a neighbor in a step leave it false
+    static const bool                 PARALLEL_STEP = false;
+
     Peer                                                    ();
     Peer                                                    (std::string);
     Peer                                                    (const Peer &);
     virtual ~Peer                                           ()=0;
     // Setters
-    void                              setID                 (std::string id)                    {_id = id;};
+    void                              setID                 (std::string id)                    {_id = id; peerNames().rename(_index, id);};
     void                              setLogFile            (std::ostream &o)                   {_log = &o;};
     void                              printNeighborhoodOn   ()                                  {_printNeighborhood = true;}
     void                              printNeighborhoodOff  ()                                  {_printNeighborhood = false;}
     virtual void                      setBusy               (bool busy)                         {_busy = busy;}
+    // the network sets this so a peer draws the same numbers in every run with the same seed
+    void                              setRandomStream       (uint32_t space, uint32_t peer)     {_streamSpace = space; _streamPeer = peer;};
     // getters
     std::vector<std::string>          neighbors             ()const;
     std::string                       id                    ()const                             {return _id;};
+    uint32_t                          index                 ()const                             {return _index;};
     bool                              isNeighbor            (std::string id)const;
+    bool                              isNeighbor            (uint32_t index)const               {return slotOf(index) != -1;};
     int                               getDelayToNeighbor    (std::string id)const;
+    int                               getDelayToNeighbor    (uint32_t index)const               {return _linkDelay.at(slotOf(index));};
     int                               getMessageCount       ()const                             {return _numberOfMessagesSent;};
     int                               getClock              ()const                             {return _clock;};
     virtual bool					  isByzantine			()const                             {return _byzantine;};
 	virtual bool					  isBusy				()									{return _busy; }
     std::deque<Packet<message> >      getInStream           ()const                             {return _inStream;};
     std::deque<Packet<message> >      getOutStream          ()const                             {return _outStream;};
+    // views of the streams for iterating in place, only valid until the peer next changes
+    const std::deque<Packet<message> >& inStream            ()const                             {return _inStream;};
+    const std::deque<Packet<message> >& outStream           ()const                             {return _outStream;};
+    int                               inFlight              ()const                             {return _inFlight.size();};
+    // first round this peer needs a preformComputation in if nothing arrives before then, NEVER if it
+    // only reacts to messages. the default is the round after the last step so peers that poll are
+    // stepped every round, peers with timers override it so they can be skipped
+    virtual int                       nextWakeup            ()const                             {return _lastStep + 1;};
+    // next round anything happens at this peer, an arrival, a wakeup or a message still in inStream
+    int                               nextEvent             ()const;
+    // true if this round's preformComputation can not be skipped
+    bool                              due                   ()const                             {return _woken || !_inStream.empty() || nextWakeup() <= _clock;};
+    // this round's stream for purpose (DELAY_STREAM, PROTOCOL_STREAM, ...)
+    RandomStream&                     random                (uint32_t purpose)                  {return _random.at(_streamSpace, _streamPeer, _clock, purpose);};
     
     
     // mutators
-    void                              removeNeighbor        (const Peer &neighbor)              {_neighbors.erase(neighbor);};
+    void                              removeNeighbor        (const Peer &neighbor);
     void                              addNeighbor           (Peer &newNeighbor, int delay);
     virtual void					  setByzantineFlag		(bool f)                            {_byzantine = f;};
     virtual void                      makeCorrect           ()                                  {_byzantine = false;};
     virtual void                      makeByzantine         ()                                  {_byzantine = true;};
     virtual void                      clearMessages         ();
+    // makes the peer due next round, for anything outside the peer that gives it work (a request, a new committee)
+    void                              wake                  ()                                  {_woken = true;};
+    // runs preformComputation and records that it ran, networks step peers through this
+    void                              step                  ()                                  {_lastStep = _clock; _woken = false; preformComputation();};
+    // skips rounds that would have been idle (nothing arrived and no wakeup)
+    void                              fastForward           (int rounds)                        {_clock += rounds;};
     // tells this peer to create a transaction
     virtual void                      makeRequest           ()=0;
-    // moves msgs from the channel to the inStream if msg delay is 0 else decrease msg delay by 1
+    // moves msgs that arrive this round from the channels to the inStream
     void                              receive               ();
     // send a message to this peer
-    void                              send                  (Packet<message>);
+    void                              send                  (Packet<message>); // pass an rvalue to move the packet into the channel
+    // queues packet (seq and body) for every peer in targets, the copies share the one body
+    void                              multicast             (const Packet<message> &packet, const std::map<std::string, Peer<message>* > &targets);
+    void                              multicast             (const Packet<message> &packet)     {multicast(packet, _neighbors);};
     // sends all messages in _outStream to there respective targets
     void                              transmit              ();
+    // first half of transmit, empties _outStream into outbox and draws the delays without touching any other peer
+    void                              route                 (std::vector<Dispatch> &outbox);
+    // second half of transmit, moves the packet to its receiver
+    static void                       dispatch              (Dispatch&);
     // preform one step of the Consensus message with the messages in inStream
     virtual void                      preformComputation    ()=0;
 
@@ -118,49 +181,79 @@ public:
 template <class message>
 Peer<message>::Peer(){
     _id = "NO ID";
+    _index = peerNames().append(_id);
     _inStream = std::deque<Packet<message> >();
     _outStream = std::deque<Packet<message> >();
     _neighbors = std::map<std::string, Peer<message>* >();
-    _channelDelays = std::map<peerId,int>();
-    _channels = std::map<peerId,aChannel>();
+    _links = std::vector<Peer<message>*>();
+    _linkIndex = std::vector<uint32_t>();
+    _linkDelay = std::vector<int>();
+    _channelTails = std::vector<int>();
+    _denseRow = true;
+    _inFlight = DeliveryQueue<Packet<message> >();
+    _random = RandomStreams();
+    _streamSpace = 0;
+    _streamPeer = _index;
     _log = &std::cout;
     _byzantine = false;
     _numberOfMessagesSent = 0;
     _printNeighborhood = false;
 	_busy = false;
     _clock = 0;
+    _lastStep = 0;
+    _woken = false;
 }
 
 template <class message>
 Peer<message>::Peer(std::string id){
     _id = id;
+    _index = peerNames().append(_id);
     _inStream = std::deque<Packet<message> >();
     _outStream = std::deque<Packet<message> >();
     _neighbors = std::map<std::string, Peer<message>* >();
-    _channelDelays = std::map<peerId,int>();
-    _channels = std::map<peerId,aChannel>();
+    _links = std::vector<Peer<message>*>();
+    _linkIndex = std::vector<uint32_t>();
+    _linkDelay = std::vector<int>();
+    _channelTails = std::vector<int>();
+    _denseRow = true;
+    _inFlight = DeliveryQueue<Packet<message> >();
+    _random = RandomStreams();
+    _streamSpace = 0;
+    _streamPeer = _index;
     _log = &std::cout;
     _byzantine = false;
     _numberOfMessagesSent = 0;
     _printNeighborhood = false;
 	_busy = false;
     _clock = 0;
+    _lastStep = 0;
+    _woken = false;
 }
 
 template <class message>
 Peer<message>::Peer(const Peer &rhs){
     _id = rhs._id;
+    _index = rhs._index;
     _inStream = rhs._inStream;
     _outStream = rhs._outStream;
     _neighbors = rhs._neighbors;
-    _channels = rhs._channels;
-    _channelDelays = rhs._channelDelays;
+    _links = rhs._links;
+    _linkIndex = rhs._linkIndex;
+    _linkDelay = rhs._linkDelay;
+    _channelTails = rhs._channelTails;
+    _denseRow = rhs._denseRow;
+    _inFlight = rhs._inFlight;
+    _random = rhs._random;
+    _streamSpace = rhs._streamSpace;
+    _streamPeer = rhs._streamPeer;
     _log = rhs._log;
     _byzantine = rhs._byzantine;
     _numberOfMessagesSent = rhs._numberOfMessagesSent;
     _printNeighborhood = rhs._printNeighborhood;
 	_busy = rhs._busy;
     _clock = rhs._clock;
+    _lastStep = rhs._lastStep;
+    _woken = rhs._woken;
 }
 
 template <class message>
@@ -174,59 +267,152 @@ void Peer<message>::addNeighbor(Peer<message> &newNeighbor, int delay){
     if(edgeDelay < 1){
         edgeDelay = 1;
     }
+    uint32_t neighborIndex = newNeighbor.index();
+    int slot = slotOf(neighborIndex);
+    if(slot == -1){
+        slot = (int)(std::lower_bound(_linkIndex.begin(), _linkIndex.end(), neighborIndex) - _linkIndex.begin());
+        _links.insert(_links.begin() + slot, &newNeighbor);
+        _linkIndex.insert(_linkIndex.begin() + slot, neighborIndex);
+        _linkDelay.insert(_linkDelay.begin() + slot, edgeDelay);
+        _channelTails.insert(_channelTails.begin() + slot, 0);
+        updateDenseRow();
+    }
     _neighbors[newNeighbor.id()] = &newNeighbor;
-    _channelDelays[newNeighbor.id()] = edgeDelay;
-    _channels[newNeighbor.id()] = std::deque<Packet<message> >();
+    _links[slot] = &newNeighbor;
+    _linkDelay[slot] = edgeDelay;
+    // (re)connecting starts the channel empty
+    _channelTails[slot] = 0;
+    _inFlight.removeIf([neighborIndex](const Packet<message> &pck){return pck.source() == neighborIndex;});
+}
+
+template <class message>
+void Peer<message>::removeNeighbor(const Peer<message> &neighbor){
+    _neighbors.erase(neighbor.id());
+    int slot = slotOf(neighbor.index());
+    if(slot == -1){
+        return;
+    }
+    _links.erase(_links.begin() + slot);
+    _linkIndex.erase(_linkIndex.begin() + slot);
+    _linkDelay.erase(_linkDelay.begin() + slot);
+    _channelTails.erase(_channelTails.begin() + slot);
+    updateDenseRow();
+}
+
+template <class message>
+void Peer<message>::updateDenseRow(){
+    if(_linkIndex.empty()){
+        _denseRow = true;
+        return;
+    }
+    uint32_t span = _linkIndex.back() - _linkIndex.front() + 1;
+    bool selfInRow = _linkIndex.front() < _index && _index < _linkIndex.back();
+    _denseRow = span == _linkIndex.size() || (selfInRow && span == _linkIndex.size() + 1);
+}
+
+// a network's peers get consecutive indices, so in a full mesh every row is dense and the slot
+// is plain arithmetic, sparser rows fall back to a binary search
+template <class message>
+int Peer<message>::slotOf(uint32_t index)const{
+    if(_linkIndex.empty() || index < _linkIndex.front() || index > _linkIndex.back() || index == _index){
+        return -1;
+    }
+    if(_denseRow){
+        return (int)(index - _linkIndex.front()) - (index > _index && _index > _linkIndex.front() ? 1 : 0);
+    }
+    auto link = std::lower_bound(_linkIndex.begin(), _linkIndex.end(), index);
+    if(*link != index){
+        return -1;
+    }
+    return (int)(link - _linkIndex.begin());
 }
 
 // called on recever
+// channels are FIFO and only the packet at the front counts down its delay, so a packet
+// starts its delay once the one ahead of it has arrived (or now if the channel is empty)
 template <class message>
 void Peer<message>::send(Packet<message> outMessage){
-    _channels.at(outMessage.sourceId()).push_back(outMessage);
+    int &tail = _channelTails.at(slotOf(outMessage.source()));
+    int arrival = std::max(tail, _clock) + 1 + outMessage.getDelay();
+    tail = arrival;
+    _inFlight.schedule(arrival, std::move(outMessage));
+}
+
+template <class message>
+void Peer<message>::multicast(const Packet<message> &packet, const std::map<std::string, Peer<message>* > &targets){
+    for(auto it = targets.begin(); it != targets.end(); ++it){
+        Packet<message> copy(packet);
+        copy.setSource(_index);
+        copy.setTarget(it->second->index());
+        _outStream.push_back(std::move(copy));
+    }
 }
 
 // called on sender
 template <class message>
 void Peer<message>::transmit(){
     // send all messages to there destantion peer channels  
+    std::vector<Dispatch> outbox;
+    route(outbox);
+    for(int i = 0; i < outbox.size(); i++){
+        dispatch(outbox[i]);
+    }
+}
+
+// only reads this peer, so every peer in a network can route at the same time
+template <class message>
+void Peer<message>::route(std::vector<Dispatch> &outbox){
     while(!_outStream.empty()){
-        
-        Packet<message> outMessage = _outStream.front();
+        Dispatch next = {this, this, std::move(_outStream.front())};
         _outStream.pop_front();
-        
+
         // if sent to self loop back next round
-        if(_id == outMessage.targetId()){
-            outMessage.setDelay(1);
-            _inStream.push_back(outMessage);
-        }else{
-            std::string targetId = outMessage.targetId();
-            int maxDelay = _channelDelays.at(targetId);
-            outMessage.setDelay(maxDelay);
-            _neighbors[targetId]->send(outMessage);
+        int maxDelay = 1;
+        if(next.packet.target() != _index){
+            int slot = slotOf(next.packet.target());
+            next.to = _links.at(slot);
+            maxDelay = _linkDelay[slot];
         }
+        next.packet.setDelay(random(DELAY_STREAM), maxDelay);
+        outbox.push_back(next);
         ++_numberOfMessagesSent;
     }
 }
 
+// writes into the receiver, callers must not dispatch to the same peer from two threads
 template <class message>
-void Peer<message>::receive() {
-	_clock++;
-	for (auto it = _neighbors.begin(); it != _neighbors.end(); ++it) {
-		std::string neighborID = it->first;
-		if (!_channels.at(neighborID).empty()) {
-			if (_channels.at(neighborID).front().hasArrived()) {
-				_inStream.push_back(_channels.at(neighborID).front());
-				_channels.at(neighborID).pop_front();
-			}
-			else {
-				_channels.at(neighborID).front().moveForward();
-			}
-		}
-	}
+void Peer<message>::dispatch(Dispatch &out){
+    if(out.to == out.from){
+        out.from->_inStream.push_back(std::move(out.packet));
+    }else{
+        out.to->send(std::move(out.packet));
+    }
+}
+
+template <class message>
+void Peer<message>::receive(){
+    _clock++;
+    if(!_inFlight.hasArrivals(_clock)){
+        return;
+    }
+    // at most one packet per channel lands in a round, deliver them in neighbor index order
+    _inFlight.collect(_clock, _inStream, [](const Packet<message> &a, const Packet<message> &b){return a.source() < b.source();});
 }
 
 
 
+template <class message>
+int Peer<message>::nextEvent()const{
+    if(_woken || !_inStream.empty() || !_outStream.empty()){
+        return _clock + 1;
+    }
+    int next = nextWakeup();
+    if(!_inFlight.empty()){
+        next = std::min(next, _inFlight.nextArrival());
+    }
+    return next;
+}
+
 template <class message>
 bool Peer<message>::isNeighbor(std::string id)const{
     if(_neighbors.find(id) != _neighbors.end()){
@@ -246,17 +432,14 @@ std::vector<std::string> Peer<message>::neighbors()const{
 
 template <class message>
 int Peer<message>::getDelayToNeighbor(std::string id)const{
-    return _channelDelays.at(id);
+    return getDelayToNeighbor(_neighbors.at(id)->index());
 }
 
 template <class message>
 void Peer<message>::clearMessages(){
+    // packets already in flight are not recalled, they still arrive
     _inStream.clear();
     _outStream.clear();
-
-    for(auto c : _channels){
-        c.second.clear();
-    }
 }
 
 template <class message>
@@ -264,17 +447,27 @@ Peer<message>& Peer<message>::operator=(const Peer<message> &rhs){
 	if(this == &rhs)
 		return *this;
     _id = rhs._id;
+    _index = rhs._index;
     _inStream = rhs._inStream;
     _outStream = rhs._outStream;
     _neighbors = rhs._neighbors;
-    _channels = rhs._channels;
-    _channelDelays = rhs._channelDelays;
+    _links = rhs._links;
+    _linkIndex = rhs._linkIndex;
+    _linkDelay = rhs._linkDelay;
+    _channelTails = rhs._channelTails;
+    _denseRow = rhs._denseRow;
+    _inFlight = rhs._inFlight;
+    _random = rhs._random;
+    _streamSpace = rhs._streamSpace;
+    _streamPeer = rhs._streamPeer;
     _log = rhs._log;
     _byzantine = rhs._byzantine;
     _numberOfMessagesSent = rhs._numberOfMessagesSent;
     _printNeighborhood = rhs._printNeighborhood;
 	_busy = rhs._busy;
     _clock = rhs._clock;
+    _lastStep = rhs._lastStep;
+    _woken = rhs._woken;
 
     return *this;
 }
@@ -294,7 +487,9 @@ std::ostream& Peer<message>::printTo(std::ostream &out)const{
         out<< "\t"<< std::setw(LOG_WIDTH)<< "Neighbor ID"<< std::setw(LOG_WIDTH)<< "Delay"<< std::setw(LOG_WIDTH)<< "Messages In Channel"<< std::endl;
         for (auto it=_neighbors.begin(); it!=_neighbors.end(); ++it){
             std::string neighborId = it->first;
-            out<< "\t"<< std::setw(LOG_WIDTH)<< neighborId<< std::setw(LOG_WIDTH)<< getDelayToNeighbor(neighborId)<< std::setw(LOG_WIDTH)<<  _channels.at(neighborId).size()<< std::endl;
+            uint32_t neighborIndex = it->second->index();
+            int inChannel = _inFlight.count([neighborIndex](const Packet<message> &pck){return pck.source() == neighborIndex;});
+            out<< "\t"<< std::setw(LOG_WIDTH)<< neighborId<< std::setw(LOG_WIDTH)<< getDelayToNeighbor(neighborId)<< std::setw(LOG_WIDTH)<<  inChannel<< std::endl;
         }
     }
     out << std::endl;
@@ -0,0 +1,130 @@
+//
+//  Random.hpp
+//  BlockGuard
+//
+//  Counter based random numbers (Philox4x32-10). A stream is addressed by
+//  (seed, space, peer, round, purpose) and its values depend on nothing
+//  else, so it does not matter which thread draws from it or how many draws
+//  other peers made first. The same seed always replays the same run.
+//
+
+#ifndef Random_hpp
+#define Random_hpp
+
+#include <cstdint>
+#include <ctime>
+#include <atomic>
+
+// what a stream is used for, streams of different purposes never overlap
+static const uint32_t DELAY_STREAM      = 0; // packet delays
+static const uint32_t PROTOCOL_STREAM   = 1; // choices a peer makes in its consensus code
+static const uint32_t TOPOLOGY_STREAM   = 2; // edges and there delays
+static const uint32_t ID_STREAM         = 3; // peer ids
+static const uint32_t SHUFFLE_STREAM    = 4; // picking Byzantine peers
+static const uint32_t COMMITTEE_STREAM  = 5; // security levels and committee members
+static const uint32_t WORKLOAD_STREAM   = 6; // requests and events made by the experiment drivers
+static const uint32_t RANDOM_PURPOSES   = 7;
+
+// peer coordinate of streams that belong to a network or a driver instead of a peer
+static const uint32_t NETWORK_STREAM    = 0xFFFFFFFFu;
+
+inline std::atomic<uint64_t>& seedStorage(){
+    static std::atomic<uint64_t> seed((uint64_t)time(nullptr));
+    return seed;
+}
+inline uint64_t simulationSeed(){return seedStorage().load();}
+inline void setSimulationSeed(uint64_t seed){seedStorage().store(seed);}
+
+// stream spaces keep networks built in the same run apart, 0 is for peers outside a network
+inline uint32_t newStreamSpace(){
+    static std::atomic<uint32_t> next(1);
+    return next++;
+}
+
+class RandomStream{
+protected:
+    uint64_t                            _seed;
+    uint32_t                            _counter[4]; // peer, round, space and purpose, block
+    uint32_t                            _block[4];
+    int                                 _used; // values of _block already handed out
+
+    void                                nextBlock           ();
+
+public:
+    typedef uint32_t                    result_type;
+
+    RandomStream                                            ()                                  {reset(0, 0, 0, 0, 0);};
+    RandomStream                                            (uint64_t seed, uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose) {reset(seed, space, peer, round, purpose);};
+
+    void                                reset               (uint64_t seed, uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose);
+    bool                                keyedFor            (uint64_t seed, uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose)const;
+
+    static constexpr result_type        min                 ()                                  {return 0;};
+    static constexpr result_type        max                 ()                                  {return 0xFFFFFFFFu;};
+    result_type                         operator()          ();
+};
+
+inline void RandomStream::reset(uint64_t seed, uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose){
+    _seed = seed;
+    _counter[0] = peer;
+    _counter[1] = round;
+    _counter[2] = (space << 8) | (purpose & 0xFF);
+    _counter[3] = 0;
+    _used = 4;
+}
+
+inline bool RandomStream::keyedFor(uint64_t seed, uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose)const{
+    return _seed == seed && _counter[0] == peer && _counter[1] == round && _counter[2] == ((space << 8) | (purpose & 0xFF));
+}
+
+inline void RandomStream::nextBlock(){
+    uint32_t x[4] = {_counter[0], _counter[1], _counter[2], _counter[3]};
+    uint32_t key[2] = {(uint32_t)_seed, (uint32_t)(_seed >> 32)};
+    for(int round = 0; round < 10; round++){
+        uint64_t product0 = (uint64_t)0xD2511F53u * x[0];
+        uint64_t product1 = (uint64_t)0xCD9E8D57u * x[2];
+        uint32_t hi0 = (uint32_t)(product0 >> 32);
+        uint32_t lo0 = (uint32_t)product0;
+        uint32_t hi1 = (uint32_t)(product1 >> 32);
+        uint32_t lo1 = (uint32_t)product1;
+        x[0] = hi1 ^ x[1] ^ key[0];
+        x[1] = lo1;
+        x[2] = hi0 ^ x[3] ^ key[1];
+        x[3] = lo0;
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+    }
+    _block[0] = x[0];
+    _block[1] = x[1];
+    _block[2] = x[2];
+    _block[3] = x[3];
+    _counter[3]++;
+    _used = 0;
+}
+
+inline RandomStream::result_type RandomStream::operator()(){
+    if(_used == 4){
+        nextBlock();
+    }
+    return _block[_used++];
+}
+
+// one lazily keyed stream per purpose, a stream is rekeyed the first time it is used in a new round
+class RandomStreams{
+protected:
+    RandomStream                        _streams[RANDOM_PURPOSES];
+
+public:
+    RandomStream&                       at                  (uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose);
+};
+
+inline RandomStream& RandomStreams::at(uint32_t space, uint32_t peer, uint32_t round, uint32_t purpose){
+    RandomStream &stream = _streams[purpose];
+    uint64_t seed = simulationSeed();
+    if(!stream.keyedFor(seed, space, peer, round, purpose)){
+        stream.reset(seed, space, peer, round, purpose);
+    }
+    return stream;
+}
+
+#endif /* Random_hpp */
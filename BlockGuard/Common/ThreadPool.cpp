@@ -0,0 +1,68 @@
+//
+//  ThreadPool.cpp
+//  BlockGuard
+//
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int threads){
+    _task = nullptr;
+    _generation = 0;
+    _pending = 0;
+    _stopping = false;
+    // the caller is worker 0, only the rest need a thread of there own
+    for(int worker = 1; worker < threads; worker++){
+        _workers.push_back(std::thread(&ThreadPool::work, this, worker));
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _start.notify_all();
+    for(int i = 0; i < _workers.size(); i++){
+        _workers[i].join();
+    }
+}
+
+void ThreadPool::work(int worker){
+    unsigned long seen = 0;
+    while(true){
+        const std::function<void(int)> *task = nullptr;
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _start.wait(guard, [&]{return _stopping || _generation != seen;});
+            if(_stopping){
+                return;
+            }
+            seen = _generation;
+            task = _task;
+        }
+        (*task)(worker);
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _pending--;
+        }
+        _finished.notify_one();
+    }
+}
+
+void ThreadPool::run(const std::function<void(int)> &task){
+    if(_workers.empty()){
+        task(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _task = &task;
+        _pending = (int)_workers.size();
+        _generation++;
+    }
+    _start.notify_all();
+    task(0);
+    std::unique_lock<std::mutex> guard(_lock);
+    _finished.wait(guard, [&]{return _pending == 0;});
+    _task = nullptr;
+}
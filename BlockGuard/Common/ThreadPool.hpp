@@ -0,0 +1,71 @@
+//
+//  ThreadPool.hpp
+//  BlockGuard
+//
+//  Fixed set of worker threads that live as long as the pool does. Each call
+//  to run hands every worker the same task and blocks until all of them are
+//  done, the calling thread works as worker 0 so a pool of size 1 never
+//  starts a thread at all.
+//
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+class ThreadPool{
+protected:
+    std::vector<std::thread>            _workers;
+    std::mutex                          _lock;
+    std::condition_variable             _start;
+    std::condition_variable             _finished;
+    const std::function<void(int)>      *_task;
+    unsigned long                       _generation; // bumped once per run so workers know there is new work
+    int                                 _pending; // workers still busy with the current task
+    bool                                _stopping;
+
+    void                                work                (int worker);
+
+public:
+    ThreadPool                                              (int threads);
+    ThreadPool                                              (const ThreadPool&) = delete;
+    ~ThreadPool                                             ();
+
+    // getters
+    int                                 size                ()const                                         {return (int)_workers.size() + 1;};
+
+    // runs task(worker) once for every worker in [0, size()) and returns when all have finished
+    void                                run                 (const std::function<void(int)>&);
+    // splits [0, count) into size() contiguous chunks in order, body(begin, end, worker) is called for each non empty chunk
+    template<class body>
+    void                                parallelFor         (int count, body);
+
+    ThreadPool&                         operator=           (const ThreadPool&) = delete;
+};
+
+template<class body>
+void ThreadPool::parallelFor(int count, body chunk){
+    if(count <= 0){
+        return;
+    }
+    int workers = std::min(size(), count);
+    if(workers == 1){
+        chunk(0, count, 0);
+        return;
+    }
+    int chunkSize = (count + workers - 1) / workers;
+    run([&](int worker){
+        int begin = worker * chunkSize;
+        int end = std::min(count, begin + chunkSize);
+        if(begin < end){
+            chunk(begin, end, worker);
+        }
+    });
+}
+
+#endif /* ThreadPool_hpp */
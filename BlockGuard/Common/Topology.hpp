@@ -0,0 +1,282 @@
+//
+//  Topology.hpp
+//  BlockGuard
+//
+//  Builders for the graphs a Network can be wired as. Nodes are positions
+//  0 .. n-1 and every builder runs in time and memory linear in the number
+//  of edges it returns, so sparse networks of 100k peers are cheap to make.
+//
+
+#ifndef Topology_hpp
+#define Topology_hpp
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+
+struct TopologyEdge{
+    int                                 from;
+    int                                 to;
+    int                                 delay; // -1 when the network should draw it from its delay distribution
+};
+
+// key for a undirected edge, used to reject duplicates
+inline uint64_t edgeKey(int a, int b){
+    if(a > b){
+        std::swap(a, b);
+    }
+    return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+// random k-regular multigraph from shuffled stubs, then every self loop or repeated edge is
+// repaired by a double edge switch with a random good edge: (a,b),(c,d) -> (a,c),(b,d)
+// meant for k <= (n-1)/2 where a switch almost always has somewhere to go
+template<class engine>
+std::vector<TopologyEdge> pairStubs(int n, int k, engine &generator){
+    std::vector<TopologyEdge> edges;
+    if(k == 0){
+        return edges;
+    }
+    std::vector<int> stubs;
+    stubs.reserve(n * (size_t)k);
+    for(int node = 0; node < n; node++){
+        for(int i = 0; i < k; i++){
+            stubs.push_back(node);
+        }
+    }
+    std::shuffle(stubs.begin(), stubs.end(), generator);
+    edges.reserve(stubs.size() / 2);
+    std::unordered_map<uint64_t, int> count; // copies of each edge
+    count.reserve(stubs.size() / 2);
+    std::vector<size_t> bad;
+    for(size_t i = 0; i + 1 < stubs.size(); i += 2){
+        int a = stubs[i];
+        int b = stubs[i + 1];
+        if(a == b || count[edgeKey(a, b)]++ > 0){
+            bad.push_back(edges.size());
+        }
+        edges.push_back({a, b, -1});
+    }
+    std::vector<bool> pending(edges.size(), false);
+    for(size_t i = 0; i < bad.size(); i++){
+        pending[bad[i]] = true;
+    }
+    std::uniform_int_distribution<size_t> pick(0, edges.size() - 1);
+    std::uniform_int_distribution<int> coin(0, 1);
+    for(size_t i = 0; i < bad.size(); i++){
+        TopologyEdge &broken = edges[bad[i]];
+        size_t attempts = 0;
+        while(true){
+            // a tiny graph can pair itself into a corner no switch gets out of
+            if(++attempts > 100 * edges.size()){
+                return pairStubs(n, k, generator);
+            }
+            size_t j = pick(generator);
+            if(pending[j]){
+                continue;
+            }
+            int a = broken.from;
+            int b = broken.to;
+            int c = edges[j].from;
+            int d = edges[j].to;
+            if(coin(generator) == 1){
+                std::swap(c, d);
+            }
+            if(a == c || b == d || edgeKey(a, c) == edgeKey(b, d) || count[edgeKey(a, c)] > 0 || count[edgeKey(b, d)] > 0){
+                continue;
+            }
+            count[edgeKey(a, b)]--;
+            count[edgeKey(edges[j].from, edges[j].to)]--;
+            count[edgeKey(a, c)]++;
+            count[edgeKey(b, d)]++;
+            broken.to = c;
+            edges[j] = {b, d, -1};
+            break;
+        }
+        pending[bad[i]] = false;
+    }
+    return edges;
+}
+
+// every node gets exactly k neighbors (n*k must be even and k < n)
+// a dense graph is the complement of a sparse one, so k > (n-1)/2 pairs stubs for n-1-k instead
+template<class engine>
+std::vector<TopologyEdge> kRegularTopology(int n, int k, engine &generator){
+    std::vector<TopologyEdge> edges;
+    if(n < 2 || k < 1 || k >= n || (n * (long long)k) % 2 != 0){
+        std::cerr<< "ERROR: no "<< k<< "-regular graph on "<< n<< " nodes"<< std::endl;
+        return edges;
+    }
+    if(2 * k <= n - 1){
+        return pairStubs(n, k, generator);
+    }
+    std::vector<TopologyEdge> missing = pairStubs(n, n - 1 - k, generator);
+    std::unordered_set<uint64_t> skip;
+    skip.reserve(missing.size());
+    for(size_t i = 0; i < missing.size(); i++){
+        skip.insert(edgeKey(missing[i].from, missing[i].to));
+    }
+    edges.reserve(n * (size_t)k / 2);
+    for(int a = 0; a < n; a++){
+        for(int b = a + 1; b < n; b++){
+            if(skip.find(edgeKey(a, b)) == skip.end()){
+                edges.push_back({a, b, -1});
+            }
+        }
+    }
+    return edges;
+}
+
+// G(n,p), every pair is an edge with probability p
+// skips straight to the next edge with a geometric draw (Batagelj and Brandes) instead of testing all pairs
+template<class engine>
+std::vector<TopologyEdge> erdosRenyiTopology(int n, double p, engine &generator){
+    std::vector<TopologyEdge> edges;
+    if(p <= 0 || n < 2){
+        return edges;
+    }
+    if(p >= 1){
+        for(int a = 0; a < n; a++){
+            for(int b = a + 1; b < n; b++){
+                edges.push_back({a, b, -1});
+            }
+        }
+        return edges;
+    }
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double logMiss = std::log(1.0 - p);
+    long long v = 1;
+    long long w = -1;
+    while(v < n){
+        double r = uniform(generator);
+        w = w + 1 + (long long)std::floor(std::log(1.0 - r) / logMiss);
+        while(w >= v && v < n){
+            w = w - v;
+            v++;
+        }
+        if(v < n){
+            edges.push_back({(int)v, (int)w, -1});
+        }
+    }
+    return edges;
+}
+
+// ring where every node links to its k/2 nearest nodes on each side (k even), then each of those
+// links is rewired to a random node with probability beta
+template<class engine>
+std::vector<TopologyEdge> wattsStrogatzTopology(int n, int k, double beta, engine &generator){
+    std::vector<TopologyEdge> edges;
+    if(k % 2 != 0 || k < 2 || k >= n){
+        std::cerr<< "ERROR: Watts-Strogatz needs an even k with 2 <= k < n, got k="<< k<< " n="<< n<< std::endl;
+        return edges;
+    }
+    int half = k / 2;
+    edges.reserve(n * (size_t)half);
+    std::unordered_set<uint64_t> used;
+    used.reserve(n * (size_t)half);
+    for(int a = 0; a < n; a++){
+        for(int j = 1; j <= half; j++){
+            int b = (a + j) % n;
+            edges.push_back({a, b, -1});
+            used.insert(edgeKey(a, b));
+        }
+    }
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::uniform_int_distribution<int> anyNode(0, n - 1);
+    for(int i = 0; i < edges.size(); i++){
+        if(coin(generator) >= beta){
+            continue;
+        }
+        int a = edges[i].from;
+        // a node already linked to every other node can not be rewired
+        int target = anyNode(generator);
+        int attempts = 0;
+        while((target == a || used.find(edgeKey(a, target)) != used.end()) && attempts < n){
+            target = anyNode(generator);
+            attempts++;
+        }
+        if(target == a || used.find(edgeKey(a, target)) != used.end()){
+            continue;
+        }
+        used.erase(edgeKey(a, edges[i].to));
+        used.insert(edgeKey(a, target));
+        edges[i].to = target;
+    }
+    return edges;
+}
+
+// preferential attachment, starts from a clique of m+1 nodes and every later node links to m distinct
+// existing nodes picked with probability proportional to there degree
+template<class engine>
+std::vector<TopologyEdge> barabasiAlbertTopology(int n, int m, engine &generator){
+    std::vector<TopologyEdge> edges;
+    if(m < 1 || m >= n){
+        std::cerr<< "ERROR: Barabasi-Albert needs 1 <= m < n, got m="<< m<< " n="<< n<< std::endl;
+        return edges;
+    }
+    edges.reserve(n * (size_t)m);
+    // every node appears once per edge it has, so a uniform pick from here is a degree weighted pick
+    std::vector<int> endpoints;
+    endpoints.reserve(2 * n * (size_t)m);
+    for(int a = 0; a <= m; a++){
+        for(int b = a + 1; b <= m; b++){
+            edges.push_back({a, b, -1});
+            endpoints.push_back(a);
+            endpoints.push_back(b);
+        }
+    }
+    std::vector<int> targets;
+    for(int node = m + 1; node < n; node++){
+        targets.clear();
+        std::uniform_int_distribution<size_t> pick(0, endpoints.size() - 1);
+        while(targets.size() < m){
+            int target = endpoints[pick(generator)];
+            if(std::find(targets.begin(), targets.end(), target) == targets.end()){
+                targets.push_back(target);
+            }
+        }
+        for(int i = 0; i < targets.size(); i++){
+            edges.push_back({node, targets[i], -1});
+            endpoints.push_back(node);
+            endpoints.push_back(targets[i]);
+        }
+    }
+    return edges;
+}
+
+// one edge per line as "from to" or "from to delay", nodes are 0 based positions, '#' starts a comment
+inline std::vector<TopologyEdge> readEdgeList(std::istream &in){
+    std::vector<TopologyEdge> edges;
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(in, line)){
+        lineNumber++;
+        size_t comment = line.find('#');
+        if(comment != std::string::npos){
+            line = line.substr(0, comment);
+        }
+        std::istringstream fields(line);
+        TopologyEdge edge = {-1, -1, -1};
+        if(!(fields>> edge.from)){
+            continue; // blank line
+        }
+        if(!(fields>> edge.to) || edge.from < 0 || edge.to < 0){
+            std::cerr<< "ERROR: bad edge on line "<< lineNumber<< std::endl;
+            continue;
+        }
+        if(!(fields>> edge.delay)){
+            edge.delay = -1;
+        }
+        edges.push_back(edge);
+    }
+    return edges;
+}
+
+#endif /* Topology_hpp */
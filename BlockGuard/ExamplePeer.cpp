@@ -32,7 +32,7 @@ void ExamplePeer::preformComputation(){
     ExampleMessage message;
     message.message = "Message: " + std::to_string(counter)  + " Hello From ";
     message.aPeerId = _id;
-    Packet<ExampleMessage> newMessage(std::to_string(counter), _id,_id);
+    Packet<ExampleMessage> newMessage(counter, _index, _index);
     newMessage.setBody(message);
     _outStream.push_back(newMessage);
     
@@ -41,7 +41,7 @@ void ExamplePeer::preformComputation(){
         ExampleMessage message;
         message.message = "Message: " + std::to_string(counter)  + " Hello From ";
         message.aPeerId = _id;
-        Packet<ExampleMessage> newMessage(std::to_string(counter), it->first,_id);
+        Packet<ExampleMessage> newMessage(counter, it->second->index(), _index);
         newMessage.setBody(message);
         _outStream.push_back(newMessage);
     }
@@ -28,6 +28,7 @@ class ExamplePeer : public Peer<ExampleMessage>{
 protected:
     int counter;
 public:
+    static const bool    PARALLEL_STEP = true; // a step only fills this peer's out stream
     // methods that must be defined when deriving from Peer
     ExamplePeer                             (std::string);
     ExamplePeer                             (const ExamplePeer &rhs);
@@ -8,7 +8,7 @@
 
 #include "Sharded_PBFT_Experiments.hpp"
 
-void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &log){
+void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &log, int threads){
     std::string header = "Committee Size,totalDef,totalHonest, Ratio Defeated Committees, Confirmed/Submitted";
     csv<< header<< std::endl;
     
@@ -20,6 +20,7 @@ void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         int secLvel = system.securityLevel1();
         
@@ -52,6 +53,7 @@ void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         int secLvel = system.securityLevel2();
         
@@ -83,6 +85,7 @@ void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         int secLvel = system.securityLevel3();
         
@@ -114,6 +117,7 @@ void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         int secLvel = system.securityLevel4();
         
@@ -145,6 +149,7 @@ void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         int secLvel = system.securityLevel5();
         
@@ -172,7 +177,7 @@ void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &
 ///////////////////////////////////////////////////////////////////////////////////////////
 //
 //
-void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log){
+void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log, int threads){
     int delay = 0;
     std::string header = "Round, Confirmed/Submitted, Average Waiting Time,  delay";
     csv<< header<< std::endl;
@@ -186,6 +191,7 @@ void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log){
         system.setMaxDelay(delay);
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         system.makeByzantines(NUMBER_OF_BYZ);
         
@@ -228,6 +234,7 @@ void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log){
         system.setMaxDelay(delay);
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         system.makeByzantines(NUMBER_OF_BYZ);
         
@@ -270,6 +277,7 @@ void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log){
         system.setMaxDelay(delay);
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         system.makeByzantines(NUMBER_OF_BYZ);
         
@@ -312,6 +320,7 @@ void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log){
         system.setMaxDelay(delay);
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         system.makeByzantines(NUMBER_OF_BYZ);
         
@@ -349,7 +358,7 @@ void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log){
 ///////////////////////////////////////////////////////////////////////////////////////////
 //
 //
-void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log){
+void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log, int threads){
     double byzantine = 0.0;
     std::string header = "Round, Confirmed/Submitted, Byzantine";
     csv<< header<< std::endl;
@@ -363,6 +372,7 @@ void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.setFaultTolerance(FAULT*2);
         system.makeByzantines(PEER_COUNT*byzantine);
         
@@ -405,6 +415,7 @@ void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.makeByzantines(PEER_COUNT*byzantine);
         system.setFaultTolerance(FAULT*2);
         
@@ -447,6 +458,7 @@ void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.makeByzantines(PEER_COUNT*byzantine);
         system.setFaultTolerance(FAULT*2);
         
@@ -489,6 +501,7 @@ void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log
         system.setToOne();
         system.setLog(log);
         system.initNetwork(PEER_COUNT);
+        system.setThreads(threads);
         system.makeByzantines(PEER_COUNT*byzantine);
         system.setFaultTolerance(FAULT*2);
         
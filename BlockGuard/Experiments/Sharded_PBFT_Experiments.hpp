@@ -29,7 +29,7 @@
 ///////////////////////////////////////////
 // MOTIVATIONAL
 //
-void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &log);
+void PBFTCommitteeSizeVsSecurityAndThoughput(std::ofstream &csv, std::ofstream &log, int threads);
 
 ///////////////////////////////////////////
 // PARAMETER
@@ -39,8 +39,8 @@ void PBFTThroughputTimeline(std::ofstream &csv, std::ofstream &log);
 ///////////////////////////////////////////
 // ADAPTIVE SECURITY PERFORMACE GRAPHS
 //
-void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log);
-void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log);
+void PBFTWaitingTimeThroughputVsDelay(std::ofstream &csv, std::ofstream &log, int threads);
+void PBFTWaitingTimeThroughputVsByzantine(std::ofstream &csv, std::ofstream &log, int threads);
 
 void PBFTDefeatedTransactionVsByzantine(std::ofstream &csv, std::ofstream &log);
 
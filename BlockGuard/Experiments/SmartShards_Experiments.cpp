@@ -154,11 +154,14 @@ std::deque<int> scheduleEvents(int numberOfEvents){
     assert(numberOfEvents <= NUMBER_OF_ROUNDS);
     std::deque<int> schedule = std::deque<int>();
     std::uniform_int_distribution<int> randomDistribution(1,NUMBER_OF_ROUNDS);
+    // each schedule gets its own stream so a run with the same seed schedules the same events
+    static uint32_t schedules = 0;
+    RandomStream generator(simulationSeed(), 0, NETWORK_STREAM, schedules++, WORKLOAD_STREAM);
 
     for(int i = 0; i < numberOfEvents; i++) {
         int randomRound = 0;
         do {
-            randomRound = randomDistribution(RANDOM_GENERATOR);
+            randomRound = randomDistribution(generator);
         } while (std::find(schedule.begin(), schedule.end(), randomRound) != schedule.end());
         schedule.push_back(randomRound);
     }
@@ -11,7 +11,7 @@
 ///////////////////////////////////////////////////////////////////
 // PBFT
 //
-void PBFT_refCom(std::string filePath){
+void PBFT_refCom(std::string filePath, int threads){
     std::cout<< "pbft_s"<<std::endl;
     std::ofstream csv;
     std::ofstream log;
@@ -24,21 +24,21 @@ void PBFT_refCom(std::string filePath){
     if ( log.fail() ){
         std::cerr << "Error: could not open file: "<< filePath + "PBFTCommitteeSizeVsSecurityAndThoughput.csv" << std::endl;
     }
-    PBFTCommitteeSizeVsSecurityAndThoughput(csv,log);
+    PBFTCommitteeSizeVsSecurityAndThoughput(csv,log,threads);
     csv.close();
     
     csv.open(filePath + "PBFTWaitingTimeThroughputVsDelay.csv");
     if ( log.fail() ){
         std::cerr << "Error: could not open file: "<< filePath + "PBFTWaitingTimeThroughputVsDelay.csv" << std::endl;
     }
-    PBFTWaitingTimeThroughputVsDelay(csv,log);
+    PBFTWaitingTimeThroughputVsDelay(csv,log,threads);
     csv.close();
     
     csv.open(filePath + "PBFTWaitingTimeThroughputVsByzantine.csv");
     if ( log.fail() ){
         std::cerr << "Error: could not open file: "<< filePath + "PBFTWaitingTimeThroughputVsByzantine.csv" << std::endl;
     }
-    PBFTWaitingTimeThroughputVsByzantine(csv,log);
+    PBFTWaitingTimeThroughputVsByzantine(csv,log,threads);
     csv.close();
     
     log.close();
@@ -23,7 +23,7 @@
 #include "Sharded_SBFT_Experiments.hpp"
 
 void SBFT_refCom(std::string filePath);
-void PBFT_refCom(std::string filePath);
+void PBFT_refCom(std::string filePath, int threads);
 void POW_refCom(std::string filePath);
 
 #endif /* refComExperiments_hpp */
@@ -47,8 +47,8 @@ bool markPBFT_message::operator==(const markPBFT_message& rhs) {
 void markPBFT_peer::setMaxWait() {
 	_maxWait = 0;
 	for (auto e : _neighbors)
-		if (e.second->getDelayToNeighbor(_id) > _maxWait) {
-			_maxWait = e.second->getDelayToNeighbor(_id);
+		if (e.second->getDelayToNeighbor(_index) > _maxWait) {
+			_maxWait = e.second->getDelayToNeighbor(_index);
 
 		}
 	++_maxWait;
@@ -94,7 +94,7 @@ void markPBFT_peer::makeRequest() {
 		// Since nodes act as client, will still accept replies since they would not normally go to
 		// byzantine node
 		_inStream.erase(std::remove_if(_inStream.begin(), _inStream.end(),
-			[](Packet<markPBFT_message> a) { return a.getMessage().type != reply; }), _inStream.end());
+			[](const Packet<markPBFT_message> &a) { return a.getMessage().type != reply; }), _inStream.end());
 		if (_inStream.empty())
 			return;
 	}
@@ -115,14 +115,15 @@ void markPBFT_peer::makeRequest() {
 
 	while (!_inStream.empty()) {
 
-		auto inmsg = _inStream.front();
-        _inStream.erase(_inStream.begin());
+		Packet<markPBFT_message> inmsg = std::move(_inStream.front());
+        _inStream.pop_front();
+        uint32_t msg = inmsg.seq(); // consensus instance the packet belongs to
 
 
         // pre-prepare phase 2
 		if ((inmsg.getMessage().type == preprepare)) {
-			if (_receivedMsgLog[inmsg.id()].find(preprepare) == _receivedMsgLog[inmsg.id()].end())
-				_receivedMsgLog[inmsg.id()][preprepare] = 1;
+			if (_receivedMsgLog[msg].find(preprepare) == _receivedMsgLog[msg].end())
+				_receivedMsgLog[msg][preprepare] = 1;
 			else
 				_state = preprepare;
 			markPBFT_message prepareMSG;
@@ -131,68 +132,70 @@ void markPBFT_peer::makeRequest() {
 			prepareMSG.type = prepare;
 			prepareMSG.creator_shard = _neighborShard;
 
-			for (auto e : _neighbors) {
-				Packet<markPBFT_message> outPacket(inmsg.id(), e.second->id(), _id);
-				outPacket.setBody(prepareMSG);
-
-				outPacket.setDelay(e.second->getDelayToNeighbor(_id), e.second->getDelayToNeighbor(_id) - 1);
+			// every copy of outPacket shares the one body
+			Packet<markPBFT_message> outPacket(inmsg.seq(), NO_PEER, _index);
+			outPacket.setBody(std::move(prepareMSG));
+			for (const auto &e : _neighbors) {
+				outPacket.setTarget(e.second->index());
+				outPacket.setDelay(random(DELAY_STREAM), e.second->getDelayToNeighbor(_index), e.second->getDelayToNeighbor(_index) - 1);
 				_outStream.push_back(outPacket);
 			}
 			// send message to self, help solve 2f+1
-			Packet<markPBFT_message> selfPacket(inmsg.id(), _id, _id);
-			selfPacket.setDelay(1, 0);
-			selfPacket.setBody(prepareMSG);
+			Packet<markPBFT_message> selfPacket(outPacket);
+			selfPacket.setTarget(_index);
+			selfPacket.setDelay(random(DELAY_STREAM), 1, 0);
 			_inStream.push_back(selfPacket);
-			_prepareSent.insert(inmsg.id());
+			_prepareSent.insert(msg);
 
 		}
 
         // phase 3 prepare
 		
-		if (inmsg.getMessage().type == prepare && (_commitSent.find(inmsg.id()) == _commitSent.end())) {
-			_msgShardCount[inmsg.id()][prepare].insert(inmsg.getMessage().creator_shard);
+		if (inmsg.getMessage().type == prepare && (_commitSent.find(msg) == _commitSent.end())) {
+			_msgShardCount[msg][prepare].insert(inmsg.getMessage().creator_shard);
 			
 			
-			if (_receivedMsgLog[inmsg.id()].find(prepare) == _receivedMsgLog[inmsg.id()].end())
-				_receivedMsgLog[inmsg.id()][prepare] = 1;
+			if (_receivedMsgLog[msg].find(prepare) == _receivedMsgLog[msg].end())
+				_receivedMsgLog[msg][prepare] = 1;
 			else
-				++_receivedMsgLog[inmsg.id()][prepare];
+				++_receivedMsgLog[msg][prepare];
 
-			if ((_receivedMsgLog[inmsg.id()][prepare] >= (int)(2 * (_faultTolerance * _neighbors.size())+1)) &&
+			if ((_receivedMsgLog[msg][prepare] >= (int)(2 * (_faultTolerance * _neighbors.size())+1)) &&
 				((int)(_faultTolerance * _neighbors.size()) != 0) &&
-				_msgShardCount[inmsg.id()][prepare].size() >= _shardCount - 1 ) {
+				_msgShardCount[msg][prepare].size() >= _shardCount - 1 ) {
 				_state = prepare;
 				markPBFT_message commitMSG;
 				commitMSG.creator_id = _id;
 				commitMSG.client_id = _id;
 				commitMSG.type = commit;
 				commitMSG.creator_shard = _neighborShard;
-				for (auto e : _neighbors) {
-					Packet<markPBFT_message> outPacket(inmsg.id(), e.second->id(), _id);
-					outPacket.setBody(commitMSG);
-					outPacket.setDelay(e.second->getDelayToNeighbor(_id), e.second->getDelayToNeighbor(_id) - 1);
+				Packet<markPBFT_message> outPacket(inmsg.seq(), NO_PEER, _index);
+				outPacket.setBody(std::move(commitMSG));
+				for (const auto &e : _neighbors) {
+					outPacket.setTarget(e.second->index());
+					outPacket.setDelay(random(DELAY_STREAM), e.second->getDelayToNeighbor(_index), e.second->getDelayToNeighbor(_index) - 1);
 					_outStream.push_back(outPacket);
 				}
-				_commitSent.insert(inmsg.id());
+				_commitSent.insert(msg);
 
 			}
 		}
 
 
         // phase 4 commit
-		if (inmsg.getMessage().type == commit && (_replySent.find(inmsg.id()) == _replySent.end())) {
-			_msgShardCount[inmsg.id()][commit].insert(inmsg.getMessage().creator_shard);
+		if (inmsg.getMessage().type == commit && (_replySent.find(msg) == _replySent.end())) {
+			_msgShardCount[msg][commit].insert(inmsg.getMessage().creator_shard);
 
-			if (_receivedMsgLog[inmsg.id()].find(commit) == _receivedMsgLog[inmsg.id()].end())
-				_receivedMsgLog[inmsg.id()][commit] = 1;
+			if (_receivedMsgLog[msg].find(commit) == _receivedMsgLog[msg].end())
+				_receivedMsgLog[msg][commit] = 1;
 			else
-				++_receivedMsgLog[inmsg.id()][commit];
+				++_receivedMsgLog[msg][commit];
 
 
 
-			if ((_receivedMsgLog[inmsg.id()][commit] >= (int)(2 * (_faultTolerance * _neighbors.size())+1)) &&
+			if ((_receivedMsgLog[msg][commit] >= (int)(2 * (_faultTolerance * _neighbors.size())+1)) &&
 				((int)(_faultTolerance * _neighbors.size()) != 0) &&
-				_msgShardCount[inmsg.id()][prepare].size() >= _shardCount - 1) {
+				_msgShardCount[msg][prepare].size() >= _shardCount - 1) {
 				_state = commit;
 				markPBFT_message replyMSG;
 				replyMSG.creator_id = _id;
@@ -202,41 +205,41 @@ void markPBFT_peer::makeRequest() {
 
 				// Primary is client, send reply to client/self 
 				if (isPrimary()) {
-					Packet<markPBFT_message> outPacket(inmsg.id(), _id, _id);
+					Packet<markPBFT_message> outPacket(inmsg.seq(), _index, _index);
 					outPacket.setBody(replyMSG);
-					outPacket.setDelay(1, 0);
+					outPacket.setDelay(random(DELAY_STREAM), 1, 0);
 					_inStream.push_back(outPacket);
 
 				}
 				else
-					for (auto e : _neighbors) {
+					for (const auto &e : _neighbors) {
 
 						if (static_cast<markPBFT_peer*>(e.second)->isPrimary()) {
-							Packet<markPBFT_message> outPacket(inmsg.id(), e.second->id(), _id);
+							Packet<markPBFT_message> outPacket(inmsg.seq(), e.second->index(), _index);
 							outPacket.setBody(replyMSG);
-							outPacket.setDelay(e.second->getDelayToNeighbor(_id), e.second->getDelayToNeighbor(_id) - 1);
+							outPacket.setDelay(random(DELAY_STREAM), e.second->getDelayToNeighbor(_index), e.second->getDelayToNeighbor(_index) - 1);
 							_outStream.push_back(outPacket);
 						}
 					}
-				_replySent.insert(inmsg.id());
+				_replySent.insert(msg);
 			}
 
 		}
 
         // phase 5 reply to primary (client)
-        if (inmsg.getMessage().type == reply && _ledger.find(inmsg.id()) == _ledger.end()) { // ledger is the list of messages gotten from other peers to this one
+        if (inmsg.getMessage().type == reply && _ledger.find(msg) == _ledger.end()) { // ledger is the list of messages gotten from other peers to this one
 
             // Add count to replylog, if not increment it
 
-            if (_receivedMsgLog[inmsg.id()].find(reply) == _receivedMsgLog[inmsg.id()].end())
-                _receivedMsgLog[inmsg.id()][reply] = 1; // counting votes as replies
+            if (_receivedMsgLog[msg].find(reply) == _receivedMsgLog[msg].end())
+                _receivedMsgLog[msg][reply] = 1; // counting votes as replies
             else
-                ++_receivedMsgLog[inmsg.id()][reply];
+                ++_receivedMsgLog[msg][reply];
 
 
-            if ((_receivedMsgLog[inmsg.id()][reply] >= (int)(2 * (_faultTolerance * _neighbors.size())+1)) &&
+            if ((_receivedMsgLog[msg][reply] >= (int)(2 * (_faultTolerance * _neighbors.size())+1)) &&
                 ((int)(_faultTolerance * _neighbors.size()) != 0)) {
-                _ledger.insert(std::make_pair(inmsg.id(), _roundCount)); //
+                _ledger.insert(std::make_pair(msg, _roundCount)); //
 				_state = idle;
             }
 
@@ -277,12 +280,13 @@ void markPBFT_peer::makeRequest() {
 				preprepareMSG.type = preprepare;
 				preprepareMSG.creator_shard = _shard;
 
-				std::string msgID = std::to_string(_roundCount) + _id + std::to_string(++_messageID);
+				uint32_t msgID = nextMessageSeq();
 
-				for (auto e : _neighbors) {
-					Packet<markPBFT_message> outPacket(msgID, e.second->id(), _id);
-					outPacket.setBody(preprepareMSG);
-					outPacket.setDelay(e.second->getDelayToNeighbor(_id));
+				Packet<markPBFT_message> outPacket(msgID, NO_PEER, _index);
+				outPacket.setBody(std::move(preprepareMSG));
+				for (const auto &e : _neighbors) {
+					outPacket.setTarget(e.second->index());
+					outPacket.setDelay(random(DELAY_STREAM), e.second->getDelayToNeighbor(_index));
 					_outStream.push_back(outPacket);
 				}
 
@@ -298,27 +302,27 @@ void markPBFT_peer::makeRequest() {
 void markPBFT_peer::makeRequest(markPBFT_message requestMSG) {
 	if (requestMSG.requestGoal == _shard) {}
 	// Create message to primary or self if primary
-	std::string toID;
+	uint32_t toIndex;
 
 	if (isPrimary()&&requestMSG.requestGoal == _shard)
-		toID = _id;
+		toIndex = _index;
 
 	std::map<std::string, Peer<markPBFT_message>*>::iterator targetPeer;
 	if (requestMSG.requestGoal == _shard && !isPrimary()) {
-		targetPeer = std::find_if(_neighbors.begin(), _neighbors.end(), [&](std::pair< std::string, Peer<markPBFT_message>*> a) {return static_cast<markPBFT_peer*>(a.second)->isPrimary(); });
-		toID = (targetPeer->second)->id();
+		targetPeer = std::find_if(_neighbors.begin(), _neighbors.end(), [&](const std::pair<const std::string, Peer<markPBFT_message>*> &a) {return static_cast<markPBFT_peer*>(a.second)->isPrimary(); });
+		toIndex = (targetPeer->second)->index();
 	}
 	else {
-		targetPeer = std::find_if(_neighbors.begin(), _neighbors.end(), [&](std::pair< std::string, Peer<markPBFT_message>*> a) {
+		targetPeer = std::find_if(_neighbors.begin(), _neighbors.end(), [&](const std::pair<const std::string, Peer<markPBFT_message>*> &a) {
 			return static_cast<markPBFT_peer*>(a.second)->getShard() == requestMSG.requestGoal; });
-		toID = (targetPeer->second)->id();
+		toIndex = (targetPeer->second)->index();
 	}
-	Packet<markPBFT_message> outPacket(requestMSG.client_id, toID, _id);
+	Packet<markPBFT_message> outPacket(requestMSG.client_id, toIndex, _index);
 	outPacket.setBody(requestMSG);
 	if (isPrimary() && requestMSG.requestGoal == _shard)
-		outPacket.setDelay(1, 0);
+		outPacket.setDelay(random(DELAY_STREAM), 1, 0);
 	else
-		outPacket.setDelay((targetPeer->second)->getDelayToNeighbor(_id), (targetPeer->second)->getDelayToNeighbor(_id) - 1);
+		outPacket.setDelay(random(DELAY_STREAM), (targetPeer->second)->getDelayToNeighbor(_index), (targetPeer->second)->getDelayToNeighbor(_index) - 1);
 	_outStream.push_back(outPacket);
 
 }
\ No newline at end of file
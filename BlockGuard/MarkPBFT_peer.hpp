@@ -64,13 +64,17 @@ private:
 	int                                                             _waitcommit;
 
 	// Message logs;
-	std::map<std::string, std::map<std::string, int>>               _receivedMsgLog; // map<msgID,map<messagetype, messageCount>>
-	std::set<std::string>                                           _preprepareSent;
-	std::set<std::string>                                           _prepareSent;
-	std::set<std::string>                                           _commitSent;
-	std::set<std::string>                                           _replySent;
-	std::map<std::string, int>                                      _ledger; // First value is messageID, second is delay to receive
-	std::map < std::string, std::map<std::string, std::set<int>>>   _msgShardCount; // map<msgID,map<messageType,list<shards>>>
+	// messages are keyed by the packet seq of the pre-prepare that started them
+	std::map<uint32_t, std::map<std::string, int>>                  _receivedMsgLog; // map<msgID,map<messagetype, messageCount>>
+	std::set<uint32_t>                                              _preprepareSent;
+	std::set<uint32_t>                                              _prepareSent;
+	std::set<uint32_t>                                              _commitSent;
+	std::set<uint32_t>                                              _replySent;
+	std::map<uint32_t, int>                                         _ledger; // First value is messageID, second is delay to receive
+	std::map<uint32_t, std::map<std::string, std::set<int>>>        _msgShardCount; // map<msgID,map<messageType,list<shards>>>
+
+	// peer index in the high bits and a count of this peer's pre-prepares below, never a label
+	uint32_t                                                        nextMessageSeq() { return ((_index & 0x7FFu) << 20) | (++_messageID & 0xFFFFF); }
 
 public:
     markPBFT_peer(std::string id) : Peer<markPBFT_message>(id), _isPrimary(false), _faultTolerance(0.3), _messageID(0), _viewCounter(0),
@@ -99,8 +103,8 @@ public:
     void                            setRoundsToRequest  (int a);
     void                            setFaultTolerance   (double setting)            { _faultTolerance = setting; }
     void                            setPrimary          (bool status);
-    std::set<std::string>&          requests            ()                          { return _preprepareSent; }
-    std::map<std::string, int>&     ledger              ()                          { return _ledger; }
+    std::set<uint32_t>&             requests            ()                          { return _preprepareSent; }
+    std::map<uint32_t, int>&        ledger              ()                          { return _ledger; }
 
     // mutators
 	void                            resetVote           ()                          { _voteChange = false; _viewCounter = 0; }
@@ -29,14 +29,9 @@ PBFTPeer_Sharded::PBFTPeer_Sharded(const PBFTPeer_Sharded &rhs) : PBFT_Peer(rhs)
 }
 
 void PBFTPeer_Sharded::braodcast(const PBFT_Message &msg){
-    for (auto it=_committeeMembers.begin(); it!=_committeeMembers.end(); ++it){
-        std::string neighborId = it->first;
-        Packet<PBFT_Message> pck(makePckId());
-        pck.setSource(_id);
-        pck.setTarget(neighborId);
-        pck.setBody(msg);
-        _outStream.push_back(pck);
-    }
+    Packet<PBFT_Message> pck(_clock);
+    pck.setBody(msg);
+    multicast(pck, _committeeMembers);
 }
 
 void PBFTPeer_Sharded::commitRequest(){
@@ -44,19 +39,9 @@ void PBFTPeer_Sharded::commitRequest(){
     commit.result = _currentRequestResult;
     commit.commit_round = _clock;
 
-    int numberOfByzantineCommits = 0;
-    int correctCommitMsg = 0;
-    for(auto commitMsg = _commitLog.begin(); commitMsg != _commitLog.end(); commitMsg++){
-        if(commitMsg->sequenceNumber == _currentRequest.sequenceNumber
-                && commitMsg->view == _currentView
-                && commitMsg->result == _currentRequestResult){
-            if(commitMsg->byzantine){
-                numberOfByzantineCommits++;
-            }else{
-                correctCommitMsg++;
-            }
-        }
-    }
+    VoteTally commits = _quorum.tally(_currentView, _currentRequest.sequenceNumber, COMMIT, _currentRequestResult);
+    int numberOfByzantineCommits = commits.byzantine;
+    int correctCommitMsg = commits.correct;
     
     // if we dont have enough honest commits and we have not heard from everyone wait
     if(correctCommitMsg <= faultyPeers()){
@@ -95,28 +80,27 @@ void PBFTPeer_Sharded::commitRequest(){
                 entry++;
             }
         }
+        _quorum.erase(oldTransaction, view);
         viewChange(_committeeMembers);
     }else if(!_currentRequest.byzantine && correctCommitMsg >= faultyPeers()){
         commit.defeated = false;
         commit.securityLevel = _committeeMembers.size()+1;
-        _ledger.push_back(commit);
-        _committeeSizes.push_back(_committeeMembers.size()+1);// +1 for self
+        int entries = appendToLedger(commit);
+        _committeeSizes.insert(_committeeSizes.end(), entries, _committeeMembers.size()+1);// +1 for self
         _currentRequest = PBFT_Message();
         clearCommittee();
         _currentRequest = PBFT_Message();
     }else{
         commit.defeated = true;
         commit.securityLevel = _committeeMembers.size()+1;
-        _ledger.push_back(commit);
-        _committeeSizes.push_back(_committeeMembers.size()+1);// +1 for self
+        int entries = appendToLedger(commit);
+        _committeeSizes.insert(_committeeSizes.end(), entries, _committeeMembers.size()+1);// +1 for self
         _currentRequest = PBFT_Message();
         clearCommittee();
         _currentRequest = PBFT_Message();
     }
     
-    for(auto confirmedTransaction = _ledger.begin(); confirmedTransaction != _ledger.end(); confirmedTransaction++){
-        cleanLogs(confirmedTransaction->sequenceNumber);
-    }
+    cleanLogs();
     _currentPhase = IDEAL; // complete distributed-consensus
     _currentRequestResult = 0;
 }
@@ -148,9 +132,7 @@ void PBFTPeer_Sharded::preformComputation(){
     waitPrepare();
     commit();
     waitCommit();
-    for(auto confirmedTransaction = _ledger.begin(); confirmedTransaction != _ledger.end(); confirmedTransaction++){
-        cleanLogs(confirmedTransaction->sequenceNumber);
-    }
+    cleanLogs();
 }
 
 PBFTPeer_Sharded& PBFTPeer_Sharded::operator= (const PBFTPeer_Sharded &rhs){
@@ -34,9 +34,6 @@ PBFTReferenceCommittee::PBFTReferenceCommittee(){
     _currentCommittees = std::vector<int>();
     _log = nullptr;
     _printNetwork = false;
-
-    int seed = (int)time(nullptr);
-    _randomGenerator = std::default_random_engine(seed);
 }
 
 PBFTReferenceCommittee::PBFTReferenceCommittee(const PBFTReferenceCommittee &rhs){
@@ -60,9 +57,6 @@ PBFTReferenceCommittee::PBFTReferenceCommittee(const PBFTReferenceCommittee &rhs
     _log = rhs._log;
     _totalTransactionsSubmitted = rhs._totalTransactionsSubmitted;
     _printNetwork = rhs._printNetwork;
-    
-    int seed = (int)time(nullptr);
-    _randomGenerator = std::default_random_engine(seed);
 }
 
 void PBFTReferenceCommittee::makeGroup(std::vector<PBFTPeer_Sharded*> group, int id){
@@ -115,10 +109,10 @@ double PBFTReferenceCommittee::pickSecrityLevel(){
 
     std::uniform_int_distribution<int> coin(0,1);
     int trails = 0;
-    int heads = coin(_randomGenerator);
+    int heads = coin(_peers.random(COMMITTEE_STREAM));
     while(!heads){
         trails++;
-        heads = coin(_randomGenerator);
+        heads = coin(_peers.random(COMMITTEE_STREAM));
     }
     
     switch (trails) {
@@ -301,7 +295,7 @@ std::vector<PBFTPeer_Sharded> PBFTReferenceCommittee::getPeers()const{
 std::vector<ledgerEntery> PBFTReferenceCommittee::getGlobalLedger()const{
     std::vector<ledgerEntery> globalLegder;
     for(int i = 0; i < _peers.size(); i++){
-        auto localLedger = _peers[i]->getLedger();
+        const std::list<PBFT_Message> &localLedger = _peers[i]->ledger();
         for(auto transaction = localLedger.begin(); transaction != localLedger.end(); transaction++){
             bool found = false;
             for(auto global = globalLegder.begin(); global != globalLegder.end(); global++){
@@ -375,8 +369,8 @@ void PBFTReferenceCommittee::shuffleByzantines(int n){
     
     int shuffleCount = 0;
     while(shuffleCount < n){
-        int byzantineShuffleIndex = static_cast<int>(rand() % byz.size());
-        int nonByzantineShuffleIndex = static_cast<int>(rand() % correct.size());
+        int byzantineShuffleIndex = static_cast<int>(_peers.random(SHUFFLE_STREAM)() % byz.size());
+        int nonByzantineShuffleIndex = static_cast<int>(_peers.random(SHUFFLE_STREAM)() % correct.size());
         _peers[byz[byzantineShuffleIndex]]->makeCorrect();
         _peers[correct[nonByzantineShuffleIndex]]->makeByzantine();
         shuffleCount++;
@@ -406,9 +400,6 @@ PBFTReferenceCommittee& PBFTReferenceCommittee::operator=(const PBFTReferenceCom
     _log = rhs._log;
     _totalTransactionsSubmitted = rhs._totalTransactionsSubmitted;
     _printNetwork = rhs._printNetwork;
-
-    int seed = (int)time(nullptr);
-    _randomGenerator = std::default_random_engine(seed);
     
     return *this;
 }
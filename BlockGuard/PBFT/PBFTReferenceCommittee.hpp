@@ -54,7 +54,6 @@ protected:
     // logging, metrics and untils
     int                                                             _totalTransactionsSubmitted;
     std::ostream                                                    *_log;
-    std::default_random_engine                                      _randomGenerator;
     std::vector<int>                                                _currentCommittees;
     bool                                                            _printNetwork;
 
@@ -77,6 +76,7 @@ public:
     void                                setFaultTolerance       (double);
     void                                setLog                  (std::ostream &o)                       {_log = &o; _peers.setLog(o);}
     void                                setSquenceNumber        (int s)                                 {_nextSquenceNumber = s;}
+    void                                setThreads              (int t)                                 {_peers.setThreads(t);}
     
     // getters
     int                                 getGroupSize            ()const                                 {return _groupSize;};
@@ -90,6 +90,8 @@ public:
     double                              securityLevel2          ()const                                 {return _securityLevel2;}
     double                              securityLevel1          ()const                                 {return _securityLevel1;}
     int                                 totalSubmissions        ()const                                 {return _totalTransactionsSubmitted;};
+    // peers stepped each round, idle groups are not stepped
+    std::vector<int>                    activeCounts            ()const                                 {return _peers.activeCounts();};
     
     aGroup                              getGroup                (int)const;
     std::vector<int>                    getGroupIds             ()const                                 {return _groupIds;};
@@ -9,12 +9,31 @@
 #include <limits>
 #include "PBFT_Peer.hpp"
 
+namespace {
+    // FNV-1a, the checkpoint digest only has to agree between peers of one run
+    const uint64_t CHECKPOINT_SEED = 14695981039346656037ULL;
+    
+    uint64_t digest(uint64_t hash, const std::string &bytes){
+        for(unsigned char byte : bytes){
+            hash = (hash ^ byte) * 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
 PBFT_Peer::PBFT_Peer(std::string id) : Peer<PBFT_Message>(id){
     _requestLog = std::list<PBFT_Message>();
     _prePrepareLog = std::list<PBFT_Message>();
     _prepareLog = std::list<PBFT_Message>();
     _commitLog = std::list<PBFT_Message>();
     _ledger = std::list<PBFT_Message>();
+    _quorum = QuorumTracker();
+    _lowWatermark = 0;
+    _committed = std::set<int>();
+    _ledgerCleaned = 0;
+    _staleLogs = false;
+    _checkpointEntries = 0;
+    _checkpointDigest = CHECKPOINT_SEED;
     
     _faultUpperBound = 0;
     
@@ -23,6 +42,11 @@ PBFT_Peer::PBFT_Peer(std::string id) : Peer<PBFT_Message>(id){
     _currentView = 0;
     _currentRequest = PBFT_Message();
     _currentRequestResult = 0;
+    _window = 1;
+    _pipeline = std::map<int, InFlight>();
+    _batchSize = 1;
+    _batchWait = 0;
+    _batchSizes = std::map<int, int>();
 }
 
 PBFT_Peer::PBFT_Peer(std::string id, double fault) : Peer<PBFT_Message>(id){
@@ -31,6 +55,13 @@ PBFT_Peer::PBFT_Peer(std::string id, double fault) : Peer<PBFT_Message>(id){
     _prepareLog = std::list<PBFT_Message>();
     _commitLog = std::list<PBFT_Message>();
     _ledger = std::list<PBFT_Message>();
+    _quorum = QuorumTracker();
+    _lowWatermark = 0;
+    _committed = std::set<int>();
+    _ledgerCleaned = 0;
+    _staleLogs = false;
+    _checkpointEntries = 0;
+    _checkpointDigest = CHECKPOINT_SEED;
     
     _faultUpperBound = fault;
     
@@ -39,6 +70,11 @@ PBFT_Peer::PBFT_Peer(std::string id, double fault) : Peer<PBFT_Message>(id){
     _currentView = 0;
     _currentRequest = PBFT_Message();
     _currentRequestResult = 0;
+    _window = 1;
+    _pipeline = std::map<int, InFlight>();
+    _batchSize = 1;
+    _batchWait = 0;
+    _batchSizes = std::map<int, int>();
 }
 
 PBFT_Peer::PBFT_Peer(const PBFT_Peer &rhs) : Peer<PBFT_Message>(rhs){
@@ -52,6 +88,13 @@ PBFT_Peer::PBFT_Peer(const PBFT_Peer &rhs) : Peer<PBFT_Message>(rhs){
     _prepareLog = rhs._prepareLog;
     _commitLog = rhs._commitLog;
     _ledger = rhs._ledger;
+    _quorum = rhs._quorum;
+    _lowWatermark = rhs._lowWatermark;
+    _committed = rhs._committed;
+    _ledgerCleaned = rhs._ledgerCleaned;
+    _staleLogs = rhs._staleLogs;
+    _checkpointEntries = rhs._checkpointEntries;
+    _checkpointDigest = rhs._checkpointDigest;
     
     _faultUpperBound = rhs._faultUpperBound;
     
@@ -60,6 +103,11 @@ PBFT_Peer::PBFT_Peer(const PBFT_Peer &rhs) : Peer<PBFT_Message>(rhs){
     _currentView = rhs._currentView;
     _currentRequest = rhs._currentRequest;
     _currentRequestResult = rhs._currentRequestResult;
+    _window = rhs._window;
+    _pipeline = rhs._pipeline;
+    _batchSize = rhs._batchSize;
+    _batchWait = rhs._batchWait;
+    _batchSizes = rhs._batchSizes;
 }
 
 PBFT_Peer& PBFT_Peer::operator=(const PBFT_Peer &rhs){
@@ -75,6 +123,13 @@ PBFT_Peer& PBFT_Peer::operator=(const PBFT_Peer &rhs){
     _prepareLog = rhs._prepareLog;
     _commitLog = rhs._commitLog;
     _ledger = rhs._ledger;
+    _quorum = rhs._quorum;
+    _lowWatermark = rhs._lowWatermark;
+    _committed = rhs._committed;
+    _ledgerCleaned = rhs._ledgerCleaned;
+    _staleLogs = rhs._staleLogs;
+    _checkpointEntries = rhs._checkpointEntries;
+    _checkpointDigest = rhs._checkpointDigest;
     
     _faultUpperBound = rhs._faultUpperBound;
     
@@ -83,31 +138,35 @@ PBFT_Peer& PBFT_Peer::operator=(const PBFT_Peer &rhs){
     _currentView = rhs._currentView;
     _currentRequest = rhs._currentRequest;
     _currentRequestResult = rhs._currentRequestResult;
+    _window = rhs._window;
+    _pipeline = rhs._pipeline;
+    _batchSize = rhs._batchSize;
+    _batchWait = rhs._batchWait;
+    _batchSizes = rhs._batchSizes;
     
     return *this;
 }
 
 void PBFT_Peer::collectMessages(){
     while(!_inStream.empty()){
-        if(_inStream.front().getMessage().type == REQUEST && _primary->id() == _id){
-            _requestLog.push_back(_inStream.front().getMessage());
-            _inStream.erase(_inStream.begin());
+        const PBFT_Message &msg = _inStream.front().getMessage();
+        if(msg.type == REQUEST && _primary->index() == _index){
+            _requestLog.push_back(msg);
             
-        }else if(_inStream.front().getMessage().phase == PRE_PREPARE){
-            _prePrepareLog.push_back(_inStream.front().getMessage());
-            _inStream.erase(_inStream.begin());
+        }else if(msg.phase == PRE_PREPARE){
+            _prePrepareLog.push_back(msg);
+            logged(msg);
             
-        }else if(_inStream.front().getMessage().phase == PREPARE){
-            _prepareLog.push_back(_inStream.front().getMessage());
-            _inStream.erase(_inStream.begin());
+        }else if(msg.phase == PREPARE){
+            _prepareLog.push_back(msg);
+            countVote(msg);
             
-        }else if(_inStream.front().getMessage().phase == COMMIT){
-            _commitLog.push_back(_inStream.front().getMessage());
-            _inStream.erase(_inStream.begin());
+        }else if(msg.phase == COMMIT){
+            _commitLog.push_back(msg);
+            countVote(msg);
             
-        }else{
-            _inStream.erase(_inStream.begin());
         }
+        _inStream.pop_front();
     }
 }
 
@@ -140,34 +199,92 @@ void PBFT_Peer::cleanLogs(int sequenceNumber){
             entry++;
         }
     }
+    _quorum.erase(sequenceNumber);
+}
+
+// the same as cleanLogs for every ledger entry, the logs are only walked when
+// something was committed or a message for a committed sequence number was logged
+void PBFT_Peer::cleanLogs(){
+    bool newCommits = _ledgerCleaned < _ledger.size();
+    auto confirmed = _ledger.end();
+    for(size_t i = _ledgerCleaned; i < _ledger.size(); i++){
+        confirmed--;
+    }
+    for(; confirmed != _ledger.end(); confirmed++){
+        if(!isCommitted(confirmed->sequenceNumber)){
+            _committed.insert(confirmed->sequenceNumber);
+        }
+    }
+    _ledgerCleaned = _ledger.size();
+    // the low watermark moves over committed sequence numbers once they are contiguous
+    while(!_committed.empty() && *_committed.begin() == _lowWatermark + 1){
+        _lowWatermark++;
+        _committed.erase(_committed.begin());
+    }
+    checkpoint();
+    
+    if(!newCommits && !_staleLogs){
+        return;
+    }
+    auto committed = [this](const PBFT_Message &entry){return isCommitted(entry.sequenceNumber);};
+    _prePrepareLog.remove_if(committed);
+    _prepareLog.remove_if(committed);
+    _commitLog.remove_if(committed);
+    _quorum.eraseRange(1, _lowWatermark);
+    _quorum.erase(_committed);
+    _staleLogs = false;
+}
+
+void PBFT_Peer::checkpoint(){
+    if(_ledger.size() < _checkpointEntries + CHECKPOINT_INTERVAL){
+        return;
+    }
+    auto entry = _ledger.end(); // walk back to the first entry after the checkpoint
+    for(size_t i = _checkpointEntries; i < _ledger.size(); i++){
+        entry--;
+    }
+    while(_ledger.size() >= _checkpointEntries + CHECKPOINT_INTERVAL){
+        for(int i = 0; i < CHECKPOINT_INTERVAL; i++, entry++){
+            // the parts of an entry every peer that committed it agrees on
+            _checkpointDigest = digest(_checkpointDigest, std::to_string(entry->sequenceNumber) + "/" + std::to_string(entry->client_id.index) + "/"
+                                       + entry->operation + std::to_string(entry->operands.first) + "," + std::to_string(entry->operands.second) + "/"
+                                       + std::to_string(entry->result) + "/" + (entry->defeated ? "d" : "c") + ";");
+        }
+        _checkpointEntries += CHECKPOINT_INTERVAL;
+    }
 }
 
 void PBFT_Peer::prePrepare(){
     if(_currentPhase != IDEAL ||
        _requestLog.empty() ||
-       _primary->id() != _id){
+       _primary->index() != _index){
         return;
     }
 
-    PBFT_Message request = _requestLog.front();
-    _requestLog.erase(_requestLog.begin());
-    
-    if(request.sequenceNumber == -1){
-        request.sequenceNumber = (int)_ledger.size() + 1;
+    PBFT_Message request;
+    if(_requestLog.front().sequenceNumber == -1){
+        if(!batchReady()){
+            return;
+        }
+        request = nextBatch();
     }else{
-        // request came with a sequenceNumber number nothing to do
+        // request came with a sequenceNumber number, it is proposed as it is
+        request = _requestLog.front();
+        _requestLog.erase(_requestLog.begin());
     }
+    _batchSizes[request.requests()]++;
     
     request.phase = PRE_PREPARE;
     request.type = REPLY;
-    request.creator_id = _id;
+    request.creator_id = PeerId(_index);
     request.byzantine = _byzantine;
     _currentPhase = PREPARE_WAIT;
     _currentRequest = request;
-    _currentRequestResult = executeQuery(request);
+    _currentRequestResult = executeBatch(request);
     PBFT_Message myPrepareMsg = request;
     myPrepareMsg.phase = PREPARE;
     _prepareLog.push_back(myPrepareMsg);
+    countVote(myPrepareMsg);
     braodcast(request);
 }
 
@@ -188,15 +305,17 @@ void PBFT_Peer::prepare(){
         return;
     }
     prePrepareMesg.phase = PREPARE;
-    _prepareLog.push_back(prePrepareMesg);
+    _prepareLog.push_back(prePrepareMesg); // the primary's prepare
+    countVote(prePrepareMesg);
     PBFT_Message prepareMsg = prePrepareMesg;
-    prepareMsg.creator_id = _id;
+    prepareMsg.creator_id = PeerId(_index);
     prepareMsg.view = _currentView;
     prepareMsg.type = REPLY;
     prepareMsg.commit_round = _clock;
     prepareMsg.phase = PREPARE;
     prepareMsg.byzantine = _byzantine;
     _prepareLog.push_back(prepareMsg);
+    countVote(prepareMsg);
     braodcast(prepareMsg);
     _currentPhase = PREPARE_WAIT;
     _currentRequest = prePrepareMesg;
@@ -206,13 +325,7 @@ void PBFT_Peer::waitPrepare(){
     if(_currentPhase != PREPARE_WAIT){
         return;
     }
-    int numberOfPrepareMsg = 0;
-    for(auto entry = _prepareLog.begin(); entry != _prepareLog.end(); entry++){
-        if(entry->sequenceNumber == _currentRequest.sequenceNumber
-           && entry->view == _currentView){
-            numberOfPrepareMsg++;
-        }
-    }
+    int numberOfPrepareMsg = _quorum.votes(_currentView, _currentRequest.sequenceNumber, PREPARE);
     if(numberOfPrepareMsg >= (faultyPeers())){
         _currentPhase = COMMIT;
     }
@@ -224,15 +337,16 @@ void PBFT_Peer::commit(){
     }
     
     PBFT_Message commitMsg = _currentRequest;
-    _currentRequestResult = executeQuery(_currentRequest);
+    _currentRequestResult = executeBatch(_currentRequest);
     
     commitMsg.phase = COMMIT;
-    commitMsg.creator_id = _id;
+    commitMsg.creator_id = PeerId(_index);
     commitMsg.type = REPLY;
     commitMsg.result = _currentRequestResult;
     commitMsg.commit_round = _clock;
     commitMsg.byzantine = _byzantine;
     _commitLog.push_back(commitMsg);
+    countVote(commitMsg);
     braodcast(commitMsg);
     _currentPhase = COMMIT_WAIT;
 }
@@ -241,13 +355,7 @@ void PBFT_Peer::waitCommit(){
     if(_currentPhase != COMMIT_WAIT){
         return;
     }
-    int numberOfCommitMsg = 0;
-    for(auto entry = _commitLog.begin(); entry != _commitLog.end(); entry++){
-        if(entry->sequenceNumber == _currentRequest.sequenceNumber
-           && entry->view == _currentView){
-            numberOfCommitMsg++;
-        }
-    }
+    int numberOfCommitMsg = _quorum.votes(_currentView, _currentRequest.sequenceNumber, COMMIT);
     // if we have enough commit messages
     if(numberOfCommitMsg >= faultyPeers()){
         commitRequest();
@@ -261,23 +369,13 @@ void PBFT_Peer::commitRequest(){
     // count the number of byzantine and correct commits
     // if more then f peers match leader commit otherwise view change (byz peers force view change until leader is byz)
     
-    int numberOfByzantineCommits = 0;
-    int correctCommitMsg = 0;
-    for(auto commitMsg = _commitLog.begin(); commitMsg != _commitLog.end(); commitMsg++){
-        if(commitMsg->sequenceNumber == _currentRequest.sequenceNumber
-           && commitMsg->view == _currentView
-           && commitMsg->result == _currentRequestResult){
-            if(commitMsg->byzantine){
-                numberOfByzantineCommits++;
-            }else{
-                correctCommitMsg++;
-            }
-        }
-    }
+    VoteTally commits = _quorum.tally(_currentView, _currentRequest.sequenceNumber, COMMIT, _currentRequestResult);
+    int numberOfByzantineCommits = commits.byzantine;
+    int correctCommitMsg = commits.correct;
     if(_currentRequest.byzantine){
         if( numberOfByzantineCommits >= faultyPeers()){
             commit.defeated = true;
-            _ledger.push_back(commit);
+            appendToLedger(commit);
             _currentRequest = PBFT_Message();
             _currentRequest = PBFT_Message();
         }else if (numberOfByzantineCommits + correctCommitMsg != _neighbors.size() +1){
@@ -285,7 +383,7 @@ void PBFT_Peer::commitRequest(){
         }else{
             if(_currentView + 1 == _neighbors.size() + 1){
                 commit.defeated = true;
-                _ledger.push_back(commit);
+                appendToLedger(commit);
                 _currentRequest = PBFT_Message();
                 _currentRequest = PBFT_Message();
             }else{
@@ -295,7 +393,7 @@ void PBFT_Peer::commitRequest(){
     }else if(!_currentRequest.byzantine){
         if( correctCommitMsg >= faultyPeers()){
             commit.defeated = false;
-            _ledger.push_back(commit);
+            appendToLedger(commit);
             _currentRequest = PBFT_Message();
             _currentRequest = PBFT_Message();
         }else if (numberOfByzantineCommits + correctCommitMsg != _neighbors.size() +1){
@@ -303,7 +401,7 @@ void PBFT_Peer::commitRequest(){
         }else{
             if(_currentView + 1 == _neighbors.size() + 1){
                 commit.defeated = true;
-                _ledger.push_back(commit);
+                appendToLedger(commit);
                 _currentRequest = PBFT_Message();
                 _currentRequest = PBFT_Message();
             }else{
@@ -312,9 +410,7 @@ void PBFT_Peer::commitRequest(){
         }
     }
     
-    for(auto confirmedTransaction = _ledger.begin(); confirmedTransaction != _ledger.end(); confirmedTransaction++){
-        cleanLogs(confirmedTransaction->sequenceNumber);
-    }
+    cleanLogs();
     _currentPhase = IDEAL; // complete distributed-consensus
     _currentRequestResult = 0;
 }
@@ -322,7 +418,7 @@ void PBFT_Peer::commitRequest(){
 void PBFT_Peer::viewChange(std::map<std::string, Peer<PBFT_Message>* > potentialPrimarys){
     _currentView++;
     _primary = findPrimary(potentialPrimarys);
-    if(_primary->id() == _id){
+    if(_primary->index() == _index){
         PBFT_Message request;
         request = _currentRequest;
         request.view = _currentView;
@@ -368,6 +464,68 @@ int PBFT_Peer::executeQuery(const PBFT_Message &query){
     }
 }
 
+int PBFT_Peer::executeBatch(const PBFT_Message &request){
+    if(request.batch == nullptr){
+        return executeQuery(request);
+    }
+    uint32_t result = 0;
+    for(auto query = request.batch->begin(); query != request.batch->end(); query++){
+        result = result * 31 + (uint32_t)executeQuery(*query);
+    }
+    return (int)result;
+}
+
+int PBFT_Peer::appendToLedger(const PBFT_Message &commit){
+    if(commit.batch == nullptr){
+        _ledger.push_back(commit);
+        return 1;
+    }
+    // the commit decided the whole batch, each request gets its own entry and result
+    for(auto query = commit.batch->begin(); query != commit.batch->end(); query++){
+        PBFT_Message entry = commit;
+        entry.batch = nullptr;
+        entry.sequenceNumber = query->sequenceNumber;
+        entry.submission_round = query->submission_round;
+        entry.client_id = query->client_id;
+        entry.operation = query->operation;
+        entry.operands = query->operands;
+        entry.result = executeQuery(*query);
+        _ledger.push_back(entry);
+    }
+    return commit.requests();
+}
+
+bool PBFT_Peer::batchReady()const{
+    int waiting = 0;
+    for(auto request = _requestLog.begin(); request != _requestLog.end() && request->sequenceNumber == -1 && waiting < _batchSize; request++){
+        waiting++;
+    }
+    return waiting >= _batchSize || _clock - (int)_requestLog.front().submission_round >= _batchWait;
+}
+
+PBFT_Message PBFT_Peer::nextBatch(){
+    int first = (int)_ledger.size() + requestsInFlight() + 1;
+    std::vector<PBFT_Message> batch;
+    while(!_requestLog.empty() && _requestLog.front().sequenceNumber == -1 && batch.size() < _batchSize){
+        batch.push_back(_requestLog.front());
+        batch.back().sequenceNumber = first + (int)batch.size() - 1;
+        _requestLog.pop_front();
+    }
+    PBFT_Message request = batch.front();
+    if(batch.size() > 1){
+        request.batch = std::make_shared<const std::vector<PBFT_Message> >(std::move(batch));
+    }
+    return request;
+}
+
+int PBFT_Peer::requestsInFlight()const{
+    int requests = 0;
+    for(auto slot = _pipeline.begin(); slot != _pipeline.end(); slot++){
+        requests += slot->second.request.requests();
+    }
+    return requests;
+}
+
 bool PBFT_Peer::isVailedRequest(const PBFT_Message &query)const{
     if(query.view != _currentView){
         return false;
@@ -379,14 +537,9 @@ bool PBFT_Peer::isVailedRequest(const PBFT_Message &query)const{
 }
 
 void PBFT_Peer::braodcast(const PBFT_Message &msg){
-    for (auto it =_neighbors.begin(); it != _neighbors.end(); ++it){
-        std::string neighborId = it->first;
-        Packet<PBFT_Message> pck(makePckId());
-        pck.setSource(_id);
-        pck.setTarget(neighborId);
-        pck.setBody(msg);
-        _outStream.push_back(pck);
-    }
+    Packet<PBFT_Message> pck(_clock);
+    pck.setBody(msg);
+    multicast(pck);
 }
 
 void PBFT_Peer::preformComputation(){
@@ -394,16 +547,90 @@ void PBFT_Peer::preformComputation(){
         _primary = findPrimary(_neighbors);
     }
     collectMessages(); // sorts messages into there repective logs
-    prePrepare();
-    prepare();
-    waitPrepare();
-    commit();
-    waitCommit();
-    for(auto confirmedTransaction = _ledger.begin(); confirmedTransaction != _ledger.end(); confirmedTransaction++){
-        cleanLogs(confirmedTransaction->sequenceNumber);
+    runPipeline();
+    cleanLogs();
+}
+
+// With a window of 1 this is prePrepare, prepare, waitPrepare, commit, waitCommit.
+// Each request in flight is loaded into the _current* varables in turn so the
+// phases run unchanged, only the oldest one may commit so the ledger stays in order.
+void PBFT_Peer::runPipeline(){
+    // start requests while there is room, the primary from its request log and the others from pre-prepares
+    while(hasRoom()){
+        InFlight oldest = current();
+        _currentPhase = IDEAL;
+        prePrepare();
+        if(_currentPhase == IDEAL){
+            prepare();
+        }
+        if(_currentPhase == IDEAL){
+            load(oldest);
+            break;
+        }
+        _pipeline[_currentRequest.sequenceNumber] = current();
+        if(_window == 1){
+            break;
+        }
+    }
+    
+    int view = _currentView;
+    std::size_t queued = _requestLog.size(); // anything past this was queued by a view change
+    for(auto slot = _pipeline.begin(); slot != _pipeline.end();){
+        load(slot->second);
+        waitPrepare();
+        commit();
+        if(slot == _pipeline.begin()){
+            waitCommit();
+        }
+        if(_currentPhase != IDEAL){
+            slot->second = current();
+            slot++;
+            continue;
+        }
+        slot = _pipeline.erase(slot);
+        if(_currentView != view){
+            break;
+        }
+    }
+    
+    // a view change restarts everything still in flight under the new primary
+    if(_currentView != view && !_pipeline.empty()){
+        if(_primary->index() == _index){
+            // the request that failed is the one viewChange queued, the rest follow it in sequence order
+            std::list<PBFT_Message> restarted;
+            restarted.splice(restarted.end(), _requestLog, std::next(_requestLog.begin(), queued), _requestLog.end());
+            for(auto slot = _pipeline.begin(); slot != _pipeline.end(); slot++){
+                PBFT_Message request = slot->second.request;
+                request.view = _currentView;
+                request.byzantine = _byzantine;
+                restarted.push_back(request);
+            }
+            // ahead of new requests so they keep the lowest sequence numbers
+            _requestLog.splice(_requestLog.begin(), restarted);
+        }
+        _pipeline.clear();
+    }
+    if(!_pipeline.empty()){
+        load(_pipeline.begin()->second);
     }
 }
 
+// consensus only moves when a message arrives, except for a request or pre-prepare left
+// waiting for the peer to finish the one it is on, or a partial batch waiting out _batchWait
+int PBFT_Peer::nextWakeup()const{
+    if(_primary == nullptr){
+        return _lastStep + 1;
+    }
+    if(!hasRoom() || (_requestLog.empty() && _prePrepareLog.empty())){
+        return NEVER;
+    }
+    if(_prePrepareLog.empty() && _primary->index() == _index && _requestLog.front().sequenceNumber == -1 && !batchReady()){
+        // a new request wakes the primary anyway, otherwise the batch goes when its oldest request has waited long enough
+        return std::max(_lastStep + 1, (int)_requestLog.front().submission_round + _batchWait);
+    }
+    return _lastStep + 1;
+}
+
 void PBFT_Peer::makeRequest(){
     if(_primary == nullptr){
         *_log<< "ERROR: makeRequest called with no primary"<< std::endl;
@@ -412,12 +639,12 @@ void PBFT_Peer::makeRequest(){
     // create request
     PBFT_Message request;
     request.submission_round = _clock;
-    request.client_id = _id;
-    request.creator_id = _id;
+    request.client_id = PeerId(_index);
+    request.creator_id = PeerId(_index);
     request.view = _currentView;
     request.type = REQUEST;
     
-    bool add = (rand()%2);
+    bool add = (random(WORKLOAD_STREAM)()%2);
     if(add){
         request.operation = ADD;
     }else{
@@ -425,8 +652,8 @@ void PBFT_Peer::makeRequest(){
     }
     
     request.operands = std::pair<int, int>();
-    request.operands.first = (rand()%100)+1;
-    request.operands.second = (rand()%100)+1;
+    request.operands.first = (random(WORKLOAD_STREAM)()%100)+1;
+    request.operands.second = (random(WORKLOAD_STREAM)()%100)+1;
     
     request.commit_round = _clock;
     request.phase = IDEAL;
@@ -434,7 +661,7 @@ void PBFT_Peer::makeRequest(){
     request.result = 0;
     request.byzantine = _byzantine;
     
-    if(_id != _primary->id()){
+    if(_index != _primary->index()){
         sendRequest(request);
     }else{
         _requestLog.push_back(request);
@@ -442,11 +669,11 @@ void PBFT_Peer::makeRequest(){
 }
 
 void PBFT_Peer::sendRequest(PBFT_Message request){
-    if(_id != _primary->id()){
+    if(_index != _primary->index()){
         // create packet for request
-        Packet<PBFT_Message> pck(makePckId());
-        pck.setSource(_id);
-        pck.setTarget(_primary->id());
+        Packet<PBFT_Message> pck(_clock);
+        pck.setSource(_index);
+        pck.setTarget(_primary->index());
         pck.setBody(request);
         _outStream.push_back(pck);
     }
@@ -461,12 +688,12 @@ void PBFT_Peer::makeRequest(int squenceNumber, int submission_round){
     // create request
     PBFT_Message request;
     request.submission_round = submission_round;
-    request.client_id = _id;
-    request.creator_id = _id;
+    request.client_id = PeerId(_index);
+    request.creator_id = PeerId(_index);
     request.view = _currentView;
     request.type = REQUEST;
     
-    bool add = (rand()%2);
+    bool add = (random(WORKLOAD_STREAM)()%2);
     if(add){
         request.operation = ADD;
     }else{
@@ -474,8 +701,8 @@ void PBFT_Peer::makeRequest(int squenceNumber, int submission_round){
     }
     
     request.operands = std::pair<int, int>();
-    request.operands.first = (rand()%100)+1;
-    request.operands.second = (rand()%100)+1;
+    request.operands.first = (random(WORKLOAD_STREAM)()%100)+1;
+    request.operands.second = (random(WORKLOAD_STREAM)()%100)+1;
     
     request.commit_round = _clock;
     request.phase = IDEAL;
@@ -485,7 +712,7 @@ void PBFT_Peer::makeRequest(int squenceNumber, int submission_round){
     
     // if this is primary then dont send to primary
     // if this is busy then dont send to primary
-    if(_currentPhase != IDEAL && id() != _primary->id()){
+    if(_currentPhase != IDEAL && _index != _primary->index()){
         sendRequest(request);
     }else{
         _requestLog.push_back(request); // this is either the primary or is free to send a new request
@@ -514,5 +741,12 @@ std::ostream& PBFT_Peer::printTo(std::ostream &out)const{
     out<< "\t"<< std::setw(LOG_WIDTH)<< "Request Log"<< std::setw(LOG_WIDTH)<< "Pre-Prepare Log Size"<< std::setw(LOG_WIDTH)<< "Prepare Log Size"<< std::setw(LOG_WIDTH)<< "Commit Log Size"<< std::setw(LOG_WIDTH)<< "Ledger Size"<<  std::endl;
     out<< "\t"<< std::setw(LOG_WIDTH)<< _requestLog.size()<< std::setw(LOG_WIDTH)<< _prePrepareLog.size()<< std::setw(LOG_WIDTH)<< _prepareLog.size()<< std::setw(LOG_WIDTH)<< _commitLog.size()<< std::setw(LOG_WIDTH)<< _ledger.size()<< std::endl;
     
+    if(!_batchSizes.empty()){
+        out<< "\t"<< std::setw(LOG_WIDTH)<< "Batch Size"<< std::setw(LOG_WIDTH)<< "Pre-Prepares Sent"<< std::endl;
+        for(auto size = _batchSizes.begin(); size != _batchSizes.end(); size++){
+            out<< "\t"<< std::setw(LOG_WIDTH)<< size->first<< std::setw(LOG_WIDTH)<< size->second<< std::endl;
+        }
+    }
+    
     return out;
 }
@@ -14,27 +14,54 @@
 #include <assert.h>
 #include <cassert>
 #include <list>
+#include <memory>
 #include "./../Common/Peer.hpp"
 #include "./../Common/DAGBlock.hpp"
+#include "QuorumTracker.hpp"
 
 //
 // PBFT Message defintion
 //
 
 // These are the type defintions for the messages
-static const std::string REQUEST = "REQUEST";
-static const std::string REPLY   = "REPLY";
+enum PBFT_Type : uint8_t {
+    NO_TYPE,
+    REQUEST,
+    REPLY
+};
 
 // These are the phase type defintions (same as peer state)
-static const std::string IDEAL         = "IDEAL";
-static const std::string PRE_PREPARE   = "PRE-PREPARE";
-static const std::string PREPARE       = "PREPARE";
-static const std::string PREPARE_WAIT  = "PREPARE_WAIT"; // waiting for messages
-static const std::string COMMIT        = "COMMIT";
-static const std::string COMMIT_WAIT   = "COMMIT_WAIT"; // waiting for messages
+enum PBFT_Phase : uint8_t {
+    NO_PHASE,
+    IDEAL,
+    PRE_PREPARE,
+    PREPARE,
+    PREPARE_WAIT, // waiting for messages
+    COMMIT,
+    COMMIT_WAIT // waiting for messages
+};
+
+// names for logging
+inline std::string typeName(PBFT_Type type){
+    static const char *names[] = {"", "REQUEST", "REPLY"};
+    return names[type];
+}
+inline std::string phaseName(PBFT_Phase phase){
+    static const char *names[] = {"", "IDEAL", "PRE-PREPARE", "PREPARE", "PREPARE_WAIT", "COMMIT", "COMMIT_WAIT"};
+    return names[phase];
+}
+inline std::ostream& operator<<(std::ostream &out, PBFT_Type type){
+    return out<< typeName(type);
+}
+inline std::ostream& operator<<(std::ostream &out, PBFT_Phase phase){
+    return out<< phaseName(phase);
+}
 
 static const std::string NO_PRIMARY    = "NO PRIMARY";
 
+// ledger entries between stable checkpoints
+static const int CHECKPOINT_INTERVAL   = 100;
+
 // operation defintions
 static const char ADD = '+';
 static const char SUBTRACT = '-';
@@ -45,11 +72,11 @@ struct PBFT_Message{
     
     unsigned int        submission_round;
     // the client is the peer that submited the request
-    std::string         client_id;
+    PeerId              client_id;
     // this is the peer that created the message
-    std::string         creator_id;
+    PeerId              creator_id;
     int                 view;
-    std::string         type;
+    PBFT_Type           type;
     char                operation;
     std::pair<int,int>  operands;
     int                 result;
@@ -57,7 +84,7 @@ struct PBFT_Message{
 
     //////////////////////////////////////////
     // phases info
-    std::string         phase;
+    PBFT_Phase          phase;
     int                 sequenceNumber;
     
     //////////////////////////////////////////
@@ -65,26 +92,30 @@ struct PBFT_Message{
     bool                byzantine;
     bool                defeated;
     int                 securityLevel;
-	DAGBlock			dagBlock;
-	bool 				dagBlockMsg = false;
+    // optional block payload, copies of the message share it instead of copying the block
+    std::shared_ptr<const DAGBlock> dagBlock;
+    bool                dagBlockMsg         ()const                 {return dagBlock != nullptr;};
+    // the requests a batched pre-prepare carries, this message is the first of them
+    std::shared_ptr<const std::vector<PBFT_Message> > batch;
+    int                 requests            ()const                 {return batch == nullptr ? 1 : (int)batch->size();};
 
     PBFT_Message(){
         submission_round= 0;
-        client_id       = "";
-        creator_id      = "";
+        client_id       = PeerId();
+        creator_id      = PeerId();
         view            = -1;
-        type            = "";
+        type            = NO_TYPE;
         operation       = ' ';
         result          = -1;
         commit_round    = -1;
-        phase           = "";
+        phase           = NO_PHASE;
         sequenceNumber  = -1;
         byzantine       = false;
         defeated        = false;
         securityLevel   = -1;
     }
 
-    bool operator==(const PBFT_Message& rhs)
+    bool operator==(const PBFT_Message& rhs)const
     {
         return(
                 submission_round== rhs.submission_round &&
@@ -126,16 +157,39 @@ protected:
     std::list<PBFT_Message>         _prepareLog;
     std::list<PBFT_Message>         _commitLog;
     std::list<PBFT_Message>         _ledger;
+    QuorumTracker                   _quorum; // prepare and commit votes in the logs, counted as they are logged
+    
+    // garbage collection, a sequence number is committed if it is in _ledger
+    int                             _lowWatermark; // 1 through _lowWatermark are all committed
+    std::set<int>                   _committed; // the other committed sequence numbers
+    size_t                          _ledgerCleaned; // ledger entries already folded into the two above
+    bool                            _staleLogs; // a message for a committed sequence number was logged since the last clean
+    int                             _checkpointEntries; // ledger entries covered by the stable checkpoint
+    uint64_t                        _checkpointDigest; // digest of those entries
     
     double                          _faultUpperBound;
     
     // status varables
     Peer<PBFT_Message>*             _primary;
-    std::string                     _currentPhase;
+    PBFT_Phase                      _currentPhase;
     int                             _currentView;
     PBFT_Message                    _currentRequest;
     int                             _currentRequestResult;
     
+    // pipelining, the _current* varables above hold the oldest request in flight
+    struct InFlight{
+        PBFT_Message                request;
+        PBFT_Phase                  phase;
+        int                         result;
+    };
+    int                             _window; // requests that may be in flight at once, 1 is one request at a time
+    std::map<int, InFlight>         _pipeline; // requests in flight by sequence number
+    
+    // batching at the primary
+    int                             _batchSize; // most requests one pre-prepare carries
+    int                             _batchWait; // rounds a request may wait at the primary for a batch to fill
+    std::map<int, int>              _batchSizes; // pre-prepares this peer sent by the number of requests they carried
+    
     //
     // protected methds for PBFT execution inside the peer
     //
@@ -147,18 +201,32 @@ protected:
     void                        waitPrepare         ();             // wait for 1/3F + 1 prepare msgs
     void                        commit              ();             // phase 3 commit
     void                        waitCommit          ();             // wait for 1/3F + 1 commit msgs ends distributed-consensus
+    void                        runPipeline         ();             // the phases above for every request in flight, commits in sequence order
     
     // support methods used for the above
     virtual void                commitRequest       ();
     virtual Peer<PBFT_Message>* findPrimary         (const std::map<std::string, Peer<PBFT_Message>*> peers);
     virtual int                 executeQuery        (const PBFT_Message&);
-    std::string                 makePckId           ()const                                         { return "Peer ID:"+_id + " round:" + std::to_string(_clock);};
+    int                         executeBatch        (const PBFT_Message&); // executeQuery, or the results of a batch folded into one
+    int                         appendToLedger      (const PBFT_Message &commit); // one ledger entry per request committed, returns how many
+    bool                        batchReady          ()const; // the front of the request log fills a batch or has waited long enough
+    PBFT_Message                nextBatch           (); // takes the next batch from the request log and numbers it
+    int                         requestsInFlight    ()const;
     virtual bool                isVailedRequest     (const PBFT_Message&)const;
     virtual void                braodcast           (const PBFT_Message&);
     void                        cleanLogs           (int); // clears logs for all transactions in _ledger
+    void                        cleanLogs           (); // clears logs of every sequence number in _ledger, only does work after a commit or a stale message
+    void                        checkpoint          (); // folds whole CHECKPOINT_INTERVALs of the ledger into the checkpoint digest
+    bool                        isCommitted         (int sequenceNumber)const       {return (sequenceNumber >= 1 && sequenceNumber <= _lowWatermark) || _committed.count(sequenceNumber) != 0;};
+    void                        logged              (const PBFT_Message &msg)       {_staleLogs = _staleLogs || isCommitted(msg.sequenceNumber);};
+    void                        countVote           (const PBFT_Message &vote)      {logged(vote); _quorum.add(vote.phase, vote.view, vote.sequenceNumber, vote.creator_id.index, vote.result, vote.byzantine);};
     void                        sendRequest         (PBFT_Message); // sends request to leader or adds request to queue if peer is the leader
+    void                        load                (const InFlight &slot)          {_currentRequest = slot.request; _currentPhase = slot.phase; _currentRequestResult = slot.result;};
+    InFlight                    current             ()const                         {return InFlight{_currentRequest, _currentPhase, _currentRequestResult};};
+    bool                        hasRoom             ()const                         {return _currentPhase == IDEAL || (_window > 1 && (int)_pipeline.size() < _window);};
     
 public:
+    static const bool           PARALLEL_STEP = true; // neighbors are only read for there index and id
     PBFT_Peer                                       (std::string id);
     PBFT_Peer                                       (std::string id, double fault);
     PBFT_Peer                                       (const PBFT_Peer &rhs);
@@ -170,15 +238,34 @@ public:
     std::vector<PBFT_Message>   getPrepareLog       ()const                                         {return std::vector<PBFT_Message>{ std::begin(_prepareLog), std::end(_prepareLog) };};
     std::vector<PBFT_Message>   getCommitLog        ()const                                         {return std::vector<PBFT_Message>{ std::begin(_commitLog), std::end(_commitLog) };};
     std::vector<PBFT_Message>   getLedger           ()const                                         {return std::vector<PBFT_Message>{ std::begin(_ledger), std::end(_ledger) };};
-    std::string                 getPhase            ()const                                         {return _currentPhase;};
+    // views of the logs and ledger for iterating without copying them
+    const std::list<PBFT_Message>& requestLog       ()const                                         {return _requestLog;};
+    const std::list<PBFT_Message>& prePrepareLog    ()const                                         {return _prePrepareLog;};
+    const std::list<PBFT_Message>& prepareLog       ()const                                         {return _prepareLog;};
+    const std::list<PBFT_Message>& commitLog        ()const                                         {return _commitLog;};
+    const std::list<PBFT_Message>& ledger           ()const                                         {return _ledger;};
+    int                         lowWatermark        ()const                                         {return _lowWatermark;};
+    int                         checkpointEntries   ()const                                         {return _checkpointEntries;};
+    uint64_t                    checkpointDigest    ()const                                         {return _checkpointDigest;};
+    PBFT_Phase                  getPhase            ()const                                         {return _currentPhase;};
     bool                        isPrimary           ()const                                         {return _primary == nullptr ? false : _id == _primary->id();};
     virtual int                 faultyPeers         ()const                                         {return ceil(double(_neighbors.size() + 1) * _faultUpperBound);};
     int                         getRound            ()const                                         {return _clock;};
     std::string                 getPrimary          ()const                                         {return _primary == nullptr ? NO_PRIMARY : _primary->id();}
     double                      getFaultTolerance   ()const                                         {return _faultUpperBound;};
+    int                         getWindow           ()const                                         {return _window;};
+    int                         inFlight            ()const                                         {return (int)_pipeline.size();};
+    int                         getBatchSize        ()const                                         {return _batchSize;};
+    int                         getBatchWait        ()const                                         {return _batchWait;};
+    const std::map<int, int>&   batchSizes          ()const                                         {return _batchSizes;};
+    int                         nextWakeup          ()const override;
     
     // setters
-    void                        setFaultTolerance   (double f)                                      {_faultUpperBound = f;};
+    void                        setFaultTolerance   (double f)                                      {_faultUpperBound = f; wake();};
+    // only PBFT_Peer::preformComputation pipelines, the sharded peers form a committee per request
+    void                        setWindow           (int w)                                         {_window = std::max(1, w); wake();};
+    // pre-prepares carry up to size requests, a partial batch goes once its oldest request has waited wait rounds
+    void                        setBatching         (int size, int wait)                            {_batchSize = std::max(1, size); _batchWait = std::max(0, wait); wake();};
  
     // mutators
     void                        clearPrimary        ()                                              {_primary = nullptr;}
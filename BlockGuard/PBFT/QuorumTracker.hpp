@@ -0,0 +1,149 @@
+//
+//  QuorumTracker.hpp
+//  BlockGuard
+//
+//  The votes a PBFT peer has counted for each (view, sequence number). Every
+//  phase keeps a bit per voter and its tallies are updated as votes arrive, so
+//  checking for a quorum is a lookup instead of a scan of the logs. A voter is
+//  counted once per phase however many copies of its vote arrive.
+//
+
+#ifndef QuorumTracker_hpp
+#define QuorumTracker_hpp
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// voters that reported one result, split by whether they are byzantine
+struct VoteTally{
+    int                                         correct = 0;
+    int                                         byzantine = 0;
+};
+
+class QuorumTracker{
+protected:
+    struct Votes{
+        std::vector<uint64_t>                   voters; // bit per voter slot
+        int                                     count = 0;
+        std::map<int, VoteTally>                results;
+    };
+    typedef std::map<int, Votes>                Phases;
+
+    std::map<int, std::map<int, Phases> >       _sequences; // sequence number -> view -> phase
+    std::unordered_map<uint32_t, int>           _slots; // voter index -> bit, in the order voters were first seen
+
+    int                 slotOf              (uint32_t voter);
+    const Votes*        find                (int view, int sequenceNumber, int phase)const;
+
+public:
+    QuorumTracker                               ()                                              {};
+
+    // counts voter's vote for phase, false if it was already counted there
+    bool                add                 (int phase, int view, int sequenceNumber, uint32_t voter, int result, bool byzantine);
+    // distinct voters of phase
+    int                 votes               (int view, int sequenceNumber, int phase)const;
+    // distinct voters of phase that reported result
+    VoteTally           tally               (int view, int sequenceNumber, int phase, int result)const;
+
+    void                erase               (int sequenceNumber)                            {_sequences.erase(sequenceNumber);};
+    // every sequence number from first through last
+    void                eraseRange          (int first, int last)                           {_sequences.erase(_sequences.lower_bound(first), _sequences.upper_bound(last));};
+    void                erase               (int sequenceNumber, int view);
+    void                erase               (const std::set<int> &sequenceNumbers);
+    void                clear               ()                                              {_sequences.clear();};
+    // (view, sequence number) pairs with votes, for logging
+    size_t              size                ()const;
+};
+
+inline int QuorumTracker::slotOf(uint32_t voter){
+    auto slot = _slots.find(voter);
+    if(slot != _slots.end()){
+        return slot->second;
+    }
+    int next = (int)_slots.size();
+    _slots[voter] = next;
+    return next;
+}
+
+inline const QuorumTracker::Votes* QuorumTracker::find(int view, int sequenceNumber, int phase)const{
+    auto sequence = _sequences.find(sequenceNumber);
+    if(sequence == _sequences.end()){
+        return nullptr;
+    }
+    auto round = sequence->second.find(view);
+    if(round == sequence->second.end()){
+        return nullptr;
+    }
+    auto votes = round->second.find(phase);
+    return votes == round->second.end() ? nullptr : &votes->second;
+}
+
+inline bool QuorumTracker::add(int phase, int view, int sequenceNumber, uint32_t voter, int result, bool byzantine){
+    Votes &votes = _sequences[sequenceNumber][view][phase];
+    int slot = slotOf(voter);
+    size_t word = slot / 64;
+    uint64_t bit = uint64_t(1) << (slot % 64);
+    if(votes.voters.size() <= word){
+        votes.voters.resize(word + 1, 0);
+    }
+    if(votes.voters[word] & bit){
+        return false;
+    }
+    votes.voters[word] |= bit;
+    votes.count++;
+    VoteTally &tally = votes.results[result];
+    if(byzantine){
+        tally.byzantine++;
+    }else{
+        tally.correct++;
+    }
+    return true;
+}
+
+inline int QuorumTracker::votes(int view, int sequenceNumber, int phase)const{
+    const Votes *votes = find(view, sequenceNumber, phase);
+    return votes == nullptr ? 0 : votes->count;
+}
+
+inline VoteTally QuorumTracker::tally(int view, int sequenceNumber, int phase, int result)const{
+    const Votes *votes = find(view, sequenceNumber, phase);
+    if(votes == nullptr){
+        return VoteTally();
+    }
+    auto tally = votes->results.find(result);
+    return tally == votes->results.end() ? VoteTally() : tally->second;
+}
+
+inline void QuorumTracker::erase(int sequenceNumber, int view){
+    auto sequence = _sequences.find(sequenceNumber);
+    if(sequence == _sequences.end()){
+        return;
+    }
+    sequence->second.erase(view);
+    if(sequence->second.empty()){
+        _sequences.erase(sequence);
+    }
+}
+
+inline void QuorumTracker::erase(const std::set<int> &sequenceNumbers){
+    for(auto sequence = _sequences.begin(); sequence != _sequences.end();){
+        if(sequenceNumbers.count(sequence->first) != 0){
+            sequence = _sequences.erase(sequence);
+        }else{
+            sequence++;
+        }
+    }
+}
+
+inline size_t QuorumTracker::size()const{
+    size_t rounds = 0;
+    for(auto sequence = _sequences.begin(); sequence != _sequences.end(); sequence++){
+        rounds += sequence->second.size();
+    }
+    return rounds;
+}
+
+#endif /* QuorumTracker_hpp */
@@ -122,7 +122,7 @@ std::ostream& operator<< (std::ostream &out, const PartitionPeer &peer) {
 }
 
 bool PartitionPeer::mineBlock() {
-	if (rand() % (doubleDelay * (_neighbors.size() + 1) / 2) == 0) {
+	if (random(PROTOCOL_STREAM)() % (doubleDelay * (_neighbors.size() + 1) / 2) == 0) {
 		return true;
 	}
 	else {
@@ -259,7 +259,7 @@ bool PartitionPeer::checkInStrm() {
 		else {
 			Partitiontransaction newTransaction;
 			newTransaction.transBlock = _inStream[i].getMessage().block;
-			newTransaction.priority = (rand() % 5) + 1;
+			newTransaction.priority = (random(PROTOCOL_STREAM)() % 5) + 1;
 			transactions.push_back(newTransaction);
 		}
 	}
@@ -285,21 +285,13 @@ void PartitionPeer::sendBlock(PartitionBlock minedBlock) {
 	PartitionBlockMessage message;
 	message.block = minedBlock;
 	message.mined = true;
+	Packet<PartitionBlockMessage> newMessage(counter);
+	newMessage.setBody(message);
 	if (!PostSplit) {
-		for (auto it = _neighbors.begin(); it != _neighbors.end(); it++)
-		{
-			Packet<PartitionBlockMessage> newMessage(std::to_string(counter), it->first, _id);
-			newMessage.setBody(message);
-			_outStream.push_back(newMessage);
-		}
+		multicast(newMessage);
 	}
 	else {
-		for (auto it = PostSplitNeighbors.begin(); it != PostSplitNeighbors.end(); it++)
-		{
-			Packet<PartitionBlockMessage> newMessage(std::to_string(counter), it->first, _id);
-			newMessage.setBody(message);
-			_outStream.push_back(newMessage);
-		}
+		multicast(newMessage, PostSplitNeighbors);
 	}
 }
 
@@ -309,22 +301,14 @@ void PartitionPeer::sendTransaction(int tranID) {
 	message.block.trans = tranID;
 	Partitiontransaction newTransaction;
 	newTransaction.transBlock = message.block;
-	newTransaction.priority = (rand() % 5) + 1;
+	newTransaction.priority = (random(WORKLOAD_STREAM)() % 5) + 1;
 	transactions.push_back(newTransaction);
+	Packet<PartitionBlockMessage> newMessage(counter);
+	newMessage.setBody(message);
 	if (!PostSplit) {
-		for (auto it = _neighbors.begin(); it != _neighbors.end(); it++)
-		{
-			Packet<PartitionBlockMessage> newMessage(std::to_string(counter), it->first, _id);
-			newMessage.setBody(message);
-			_outStream.push_back(newMessage);
-		}
+		multicast(newMessage);
 	}
 	else {
-		for (auto it = PostSplitNeighbors.begin(); it != PostSplitNeighbors.end(); it++)
-		{
-			Packet<PartitionBlockMessage> newMessage(std::to_string(counter), it->first, _id);
-			newMessage.setBody(message);
-			_outStream.push_back(newMessage);
-		}
+		multicast(newMessage, PostSplitNeighbors);
 	}
 }
\ No newline at end of file
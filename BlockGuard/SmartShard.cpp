@@ -16,7 +16,7 @@ SmartShard::SmartShard(const int& shards, std::ostream& out, int delay, int peer
 		_system[i]->setToRandom();
 		_system[i]->setMaxDelay(delay);
 		_system[i]->initNetwork(_peersPerShard);
-		(*_system[i])[rand() % _peersPerShard]->setPrimary(true);
+		(*_system[i])[_system[i]->random(WORKLOAD_STREAM)() % _peersPerShard]->setPrimary(true);
 		for (int j = 0; j < _peersPerShard; ++j) {
             (*_system[i])[j]->setShard(i);
             (*_system[i])[j]->setShardCount(_shards);
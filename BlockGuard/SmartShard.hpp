@@ -123,9 +123,9 @@ public:
             if(getByzantine() == _peers.size()){return;}// all peers are dead
 
             if(_numberOfPeersInReserve == 0){
-                int peerToDrop = rand()%_peers.size();
+                int peerToDrop = workload() % _peers.size();
                 while (isByzantine(peerToDrop)) {
-                    peerToDrop = rand() % _peers.size();
+                    peerToDrop = workload() % _peers.size();
                 }
                 makeByzantine(peerToDrop);
                 std::cerr << "no reserve peers, dropping peer\n";
@@ -211,15 +211,15 @@ public:
 
 		void makeRequest(int forQuorum = -1, int toQuorum = -1, int toPeer = -1) {
 			if (forQuorum == -1) {
-				forQuorum = rand() % _shards;
+				forQuorum = workload() % _shards;
 			}
 
 			if (toQuorum == -1) {
-				toQuorum = rand() % _shards;
+				toQuorum = workload() % _shards;
 			}
 
 			if (toPeer == -1) {
-				toPeer = rand() % _peersPerShard;
+				toPeer = workload() % _peersPerShard;
 			}
 
 			markPBFT_message requestMSG;
@@ -258,6 +258,9 @@ private:
 	int _numberOfPeersInReserve;
 	std::map<int, std::set<markPBFT_peer*>> _peers; // peer id, to list of real peers that it is in the quorums (vir peers)
 
+	// the first shard's workload stream, drops and requests made here replay with the same seed
+	uint32_t workload() { return _system.front()->random(WORKLOAD_STREAM)(); }
+
 
 };
 
@@ -3,25 +3,28 @@
 //
 
 #include "bCoin_Peer.hpp"
-std::default_random_engine bCoin_Peer:: generator;
-std::binomial_distribution<int> bCoin_Peer::distribution(10, 0.5);
 
 bCoin_Peer::bCoin_Peer(std::string id) : Peer<bCoinMessage>(id){
     counter = 0;
     blockchain = new Blockchain(true);
-    mineNextAt = -1;
+    mineAt = -1;
 }
 
 bCoin_Peer::bCoin_Peer(const bCoin_Peer &rhs) {
     counter = rhs.counter;
     *blockchain = *rhs.blockchain;
-    mineNextAt = rhs.mineNextAt;
+    mineAt = rhs.mineAt;
+}
+
+int bCoin_Peer::miningDelay() {
+    std::binomial_distribution<int> distribution(10, 0.5);
+    return distribution(random(PROTOCOL_STREAM));
 }
 
 bool bCoin_Peer::mineBlock() {
     std::cerr<<"Mining for Block "<<blockchain->getChainSize()<<std::endl;
-    if(mineNextAt == 0){
-        mineNextAt+= distribution(generator);
+    if(mineAt >= 0 && mineAt <= _clock){
+        mineAt = _clock + miningDelay();
         blockchain->createBlock(blockchain->getChainSize(), blockchain->getLatestBlockHash(), std::to_string(blockchain->getChainSize())+"_"+id(), {id()});
         return true;
     }
@@ -35,18 +38,13 @@ void bCoin_Peer::sendBlock(){
     bCMessage.length = blockchain->getChainSize();
     std::cerr<<bCMessage.length<<std::endl;
 
-    std::vector<std::string> listOfTargets = neighbors();
-    for(int i = 0; i < listOfTargets.size(); i++) {
-        std::string targetId = listOfTargets[i];
-        Packet<bCoinMessage> newMessage("", targetId, _id);
-        newMessage.setBody(bCMessage);
-        _outStream.push_back(newMessage);
-    }
+    Packet<bCoinMessage> newMessage(0);
+    newMessage.setBody(bCMessage);
+    multicast(newMessage);
 }
 
 void bCoin_Peer::preformComputation(){
     std::cerr<<"Performing computation for peer "<<id()<<std::endl;
-    mineNextAt--;
     //update own blockchain with the longest chain
     receiveBlock();
     bool mined = mineBlock();
@@ -79,7 +77,7 @@ void bCoin_Peer::receiveBlock() {
             }
         }
         //set the new mining delay
-        mineNextAt = ( distribution(generator) );
+        mineAt = _clock + miningDelay();
     }
     _inStream.clear();
 }
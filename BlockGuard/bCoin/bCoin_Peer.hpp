@@ -43,20 +43,24 @@ class bCoin_Peer : public Peer<bCoinMessage> {
 
     int 											counter;
     Blockchain*			 							blockchain;
-    int                                             mineNextAt;
+    int                                             mineAt; // round the next block is found in
 
 public:
-    static std::default_random_engine       generator;
-    static std::binomial_distribution<int>  distribution;
-
     bCoin_Peer																	    (std::string);
     bCoin_Peer                                                                      (const bCoin_Peer &rhs);
-    void                                    setMineNextAt                           (int iter)                  { mineNextAt = iter; }
-    int                                     getMineNextAt                           ()                          { return mineNextAt; }
+    // iter rounds from now, 0 or less never
+    void                                    setMineNextAt                           (int iter)                  { mineAt = iter > 0 ? _clock + iter : -1; }
+    int                                     getMineNextAt                           ()                          { return mineAt - _clock; }
+    // rounds until this peer finds its next block, binomial(10, 0.5) drawn from this peer's stream
+    int                                     miningDelay                             ();
+    // adopting a chain copies its tip handle, the blocks are shared
     void 									setBlockchain							(const Blockchain &bChain)  { *(this->blockchain) = bChain; }
     Blockchain*                             getBlockchain                           ()                          { return this->blockchain; }
 
     void 									preformComputation						() override;
+    // between blocks a miner only needs to be stepped in the round it finds one, or the next round it
+    // gets if that one has already gone by
+    int                                     nextWakeup                              ()const override            { return mineAt < 0 ? NEVER : std::max(mineAt, _lastStep + 1); }
 
     bool 									mineBlock                               ();
     void                                    receiveBlock                            ();
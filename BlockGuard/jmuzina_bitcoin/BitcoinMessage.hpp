@@ -2,44 +2,75 @@
 #define JMUZINA_BCOINMSG
 
 #include "../Common/Block.hpp"
+#include <string>
+#include <vector>
 
-struct BitcoinMessage {
-    Block block;
-    std::string peerId;
-    int length;
+// Blocks are relayed headers first, as in Bitcoin. A miner announces each new tip to its neighbors
+// with an INV. A neighbor one block behind fetches that block with GET_DATA, one further behind or
+// on another branch sends GET_HEADERS with a locator of its chain, checks the HEADERS past the fork
+// and then GET_DATAs their blocks. Nothing is read out of another miner's chain.
+static const std::string INV            = "INV";
+static const std::string GET_HEADERS    = "GETHEADERS";
+static const std::string HEADERS        = "HEADERS";
+static const std::string GET_DATA       = "GETDATA";
+static const std::string BLOCK          = "BLOCK";
 
-    BitcoinMessage() {
-        block = Block();
-        peerId = -1;
-        length = 0;
+// Sizes in Bitcoin's wire encoding, in bytes
+static const int MESSAGE_HEADER_BYTES   = 24; // magic, command, length and checksum
+static const int HASH_BYTES             = 32;
+static const int INV_ENTRY_BYTES        = 36; // type and hash
+static const int BLOCK_HEADER_BYTES     = 80;
+static const int DEFAULT_BLOCK_BYTES    = 1000000; // a whole block, simulated blocks carry no transactions so the body is only counted
+static const int MAX_HEADERS            = 2000; // headers per HEADERS reply
+
+// Name an inv, locator or getdata entry gives a block, a 32 byte hash on the wire. The simulated
+// hash is digest:nonce and every miner's first block is "genesisHash:-1", so the miner is part of it.
+struct BlockRef {
+    int height;
+    std::string hash;
+
+    BlockRef() {
+        height = -1;
+        hash = "";
     }
 
-    BitcoinMessage(const std::string id) {
-        block = Block();
-        peerId = id;
-        length = 1;
+    explicit BlockRef(const Block& block) {
+        height = block.getIndex();
+        hash = block.getHash() + "/" + (block.getPublishers().empty() ? "" : *block.getPublishers().begin());
     }
+};
 
-    BitcoinMessage(const Block& newBlock, const std::string id, const int len) {
-        block = newBlock;
-        peerId = id;
-        length = len;
+struct BitcoinMessage {
+    std::string type;
+    std::string peerId; // sender
+    std::vector<BlockRef> refs; // INV and GET_DATA entries, the GET_HEADERS locator
+    std::vector<Block> blocks; // HEADERS sends their headers, BLOCK the whole blocks
+    int blockBytes; // size of each whole block a BLOCK carries
+
+    BitcoinMessage() {
+        type = "";
+        peerId = "";
+        blockBytes = DEFAULT_BLOCK_BYTES;
     }
 
-    // Copy constructor
-    BitcoinMessage(const BitcoinMessage& copy) { 
-        block = copy.block; 
-        peerId = copy.peerId;
-        length = copy.length;
+    BitcoinMessage(const std::string& msgType, const std::string id) {
+        type = msgType;
+        peerId = id;
+        blockBytes = DEFAULT_BLOCK_BYTES;
     }
 
-    // Equal operator overload
-    BitcoinMessage& operator=(const BitcoinMessage& rhs) {
-        block = rhs.block;
-        peerId = rhs.peerId;
-        length = rhs.length;
-        return *this;
+    // bytes this message takes on the wire. The blocks answering one GET_DATA travel as one packet
+    // but are counted as the separate BLOCK messages Bitcoin would send.
+    long long size() const {
+        if (type == INV || type == GET_DATA) return MESSAGE_HEADER_BYTES + countBytes(refs.size()) + (long long)INV_ENTRY_BYTES * refs.size();
+        if (type == GET_HEADERS) return MESSAGE_HEADER_BYTES + 4 + countBytes(refs.size()) + (long long)HASH_BYTES * (refs.size() + 1); // version, locator and stop hash
+        if (type == HEADERS) return MESSAGE_HEADER_BYTES + countBytes(blocks.size()) + (long long)(BLOCK_HEADER_BYTES + 1) * blocks.size(); // each header has an empty transaction count
+        if (type == BLOCK) return (long long)(MESSAGE_HEADER_BYTES + blockBytes) * blocks.size();
+        return MESSAGE_HEADER_BYTES;
     }
+
+    // bytes of the variable length integer a list count is sent as
+    static int countBytes(size_t count) { return (count < 253 ? 1 : count <= 0xFFFF ? 3 : count <= 0xFFFFFFFFull ? 5 : 9); }
 };
 
 class splitHash {
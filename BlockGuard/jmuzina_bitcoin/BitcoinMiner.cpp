@@ -1,5 +1,7 @@
 #include "BitcoinMiner.hpp"
 #include <iostream>     
+#include <algorithm>
+#include <cmath>
 
 // Returns parsed blockhash and solution nonce
 splitHash::splitHash(std::string fullHash) {
@@ -28,30 +30,120 @@ splitHash::splitHash(std::string fullHash) {
     }
 }
 
-// Returns a miner pointer given their ID
-BitcoinMiner* BitcoinMiner::findMiner(const std::string id) {
-    return dynamic_cast<BitcoinMiner*>(_neighbors.find(id)->second);
-}
+// Nonces hashed per call into the SHA kernels, a round's budget is spent in chunks of this size
+static const int HASH_CHUNK = 256;
+
+// Zero bits a solution needs unless setDifficulty or setTarget says otherwise, the same as a "000" hex prefix
+static const int DEFAULT_DIFFICULTY = 12;
 
 BitcoinMiner::BitcoinMiner(const std::string id) {
     curChain = new Blockchain(true);
     _id = id;
     lastNonce = 0;
+    hashRate = 1;
+    target = zeroBitsTarget(DEFAULT_DIFFICULTY);
+    sampledMining = false;
+    realHashing = false;
+    solveHash = -1;
+    solveAttempts = 0;
     experimentOver = false;
+    beaten = false;
+    blockBytes = DEFAULT_BLOCK_BYTES;
+    pendingUntil = 0;
+    refreshPrefix();
+}
+
+// Midstates are kept for recent tips only, the cache is emptied when it fills
+static const int MIDSTATE_CACHE_SIZE = 256;
+
+const Sha256Prefix& BitcoinMiner::midstateFor(const std::string& prevHash) {
+    auto cached = midstates.find(prevHash);
+    if (cached != midstates.end()) return cached->second;
+    if (midstates.size() >= MIDSTATE_CACHE_SIZE) midstates.clear();
+    return midstates.emplace(prevHash, Sha256Prefix(prevHash)).first->second;
+}
+
+void BitcoinMiner::refreshPrefix() {
+    const int curLength = curChain->getChainSize();
+    const std::string prevHash = (curLength > 1 ? splitHash(curChain->getBlockAt(curLength - 1).getHash()).getHash() : "");
+    miningPrefix = midstateFor(prevHash).extended(_id);
+    // a new tip is a new puzzle, the draw starts over
+    if (prevHash != miningTip) solveHash = -1;
+    miningTip = prevHash;
+}
+
+long long BitcoinMiner::attemptsUntilSolved() {
+    const double probability = targetProbability(target);
+    if (probability >= 1.0) return 1;
+    // 53 bit uniform in (0, 1], inverted through the geometric distribution
+    RandomStream &rng = random(PROTOCOL_STREAM);
+    const uint64_t high = rng();
+    const uint64_t low = rng();
+    const double uniform = (double)((((high << 32) | low) >> 11) + 1) * std::ldexp(1.0, -53);
+    const double attempts = 1.0 + std::floor(std::log(uniform) / std::log1p(-probability));
+    return (attempts < 1e18 ? (long long)attempts : 1000000000000000000LL);
+}
+
+void BitcoinMiner::mineSampled(long long nonce) {
+    if (realHashing) {
+        // search for a real solution so the block holds up to the same checks as a mined one
+        int solvedAt = -1;
+        nonce = 0;
+        while (solvedAt == -1) {
+            attempts.resize(HASH_CHUNK);
+            getSHA(nonce, HASH_CHUNK, attempts.data());
+            for (int i = 0; i < HASH_CHUNK && solvedAt == -1; ++i) {
+                if (meetsTarget(attempts[i], target)) solvedAt = i;
+            }
+            if (solvedAt == -1) nonce += HASH_CHUNK;
+        }
+        setLastNonce(nonce + solvedAt);
+        mineNext(digestHex(attempts[solvedAt]));
+    }
+    else {
+        // one hash ties the block to its tip and miner, it is not expected to meet the target
+        Digest digest;
+        getSHA(nonce, 1, &digest);
+        setLastNonce(nonce);
+        mineNext(digestHex(digest));
+    }
+    setLastNonce(0);
+}
+
+int BitcoinMiner::nextWakeup() const {
+    if (!sampledMining || solveHash < 0 || curChain->getChainSize() <= 1) return Peer<BitcoinMessage>::nextWakeup();
+    return (int)std::min<long long>(solveHash / (hashRate > 0 ? hashRate : 1), NEVER - 1);
+}
+
+Digest BitcoinMiner::blockDigest(const std::string& prevHash, const std::string& minerId, long long nonce) {
+    Digest digest;
+    sha256Nonces(midstateFor(prevHash).extended(minerId), nonce, 1, &digest);
+    return digest;
+}
+
+// Compares in binary, the claimed hex is only parsed, never rebuilt from the digest. A block any
+// miner has verified already is looked up instead of hashed again.
+bool BitcoinMiner::hashMatches(const std::string& claimedHex, const std::string& prevHash, const std::string& minerId, long long nonce) {
+    Digest claimed;
+    if (!digestFromHex(claimedHex, claimed)) return false;
+    if (verificationCache().contains(claimed, prevHash, minerId, nonce)) return true;
+    const bool matches = claimed == blockDigest(prevHash, minerId, nonce);
+    if (matches) verificationCache().insert(claimed, prevHash, minerId, nonce);
+    return matches;
 }
 
 // Deterministically returns a randomly outputed string,
 // using the previous block's hash, current miner ID,
 // and an incremented nonce as input.
 std::string BitcoinMiner::getSHA(long long nonce) const {
-    const int curLength = curChain->getChainSize();
-    const std::string prevHash = (curLength > 1 ? splitHash(curChain->getBlockAt(curLength - 1).getHash()).getHash() : "");
-    std::string hash_hex_str;
-    picosha2::hash256_hex_string(prevHash + _id + std::to_string(nonce), hash_hex_str);
-
-    //if (hash_hex_str.substr(0,2) == "00") std::cerr << "HO(" << prevHash << ", " << _id << ", " << std::to_string(nonce) << ") =\t" << hash_hex_str << "\n";
+    Digest digest;
+    getSHA(nonce, 1, &digest);
+    return digestHex(digest);
+}
 
-    return hash_hex_str;
+// Same hash for a run of nonces, starting from the midstate of the current tip's hash + id.
+void BitcoinMiner::getSHA(long long first, int count, Digest* out) const {
+    sha256Nonces(miningPrefix, first, count, out);
 }
 
 // Handles main mining logic
@@ -60,16 +152,54 @@ void BitcoinMiner::preformComputation() {
     readBlock();
     // continues executing until we've mined an arbitrary number of blocks
     if (curChain->getChainSize() != 100) {
-        std::string hash = (curChain->getChainSize() > 1 ? getSHA(lastNonce) : "genesisHash"); // Miner's attempted Proof of Work solution
-        std::string challengeBits = hash.substr(0, 3); // Arbitrary first few bits of attempted solution
-        // Valid PoW solution - send block to other miners
-        if ((challengeBits == "000" || hash == "genesisHash")) { 
-            mineNext(hash);
+        if (curChain->getChainSize() <= 1) {
+            mineNext("genesisHash");
             setLastNonce(0);
         }
-        // PoW solution was incorrect, increment nonce
+        else if (sampledMining) {
+            // Blocks whose drawn hash falls in this round's budget are found, the rest of the round
+            // goes to the next tip. Nothing is hashed in rounds without a block.
+            const long long rate = (hashRate > 0 ? hashRate : 1);
+            const long long roundEnd = ((long long)_clock + 1) * rate;
+            if (solveHash < 0) {
+                solveAttempts = attemptsUntilSolved();
+                solveHash = (long long)_clock * rate + solveAttempts - 1;
+            }
+            while (solveHash < roundEnd && curChain->getChainSize() != 100) {
+                const long long solvedAt = solveHash;
+                const bool wasBeaten = getBeaten();
+                mineSampled(solveAttempts - 1);
+                // A beaten miner drops its solution and searches the same tip from nonce 0 again, so
+                // it finds the same nonce after as many hashes. Otherwise the next tip is a new draw.
+                if (!wasBeaten) solveAttempts = attemptsUntilSolved();
+                solveHash = solvedAt + solveAttempts;
+            }
+        }
         else {
-            setLastNonce(lastNonce + 1);
+            // Spend this round's hash budget in chunks, a solution part way through starts the
+            // next block on the new tip with what is left of the budget
+            long long budget = (hashRate > 0 ? hashRate : 1);
+            while (budget > 0 && curChain->getChainSize() != 100) {
+                const int chunk = (int)std::min<long long>(budget, HASH_CHUNK);
+                attempts.resize(chunk);
+                getSHA(lastNonce, chunk, attempts.data());
+                int solvedAt = -1;
+                for (int i = 0; i < chunk && solvedAt == -1; ++i) {
+                    if (meetsTarget(attempts[i], target)) solvedAt = i;
+                }
+                // Valid PoW solution - send block to other miners, the block keeps the hash as hex
+                if (solvedAt != -1) {
+                    budget -= solvedAt + 1;
+                    setLastNonce(lastNonce + solvedAt);
+                    mineNext(digestHex(attempts[solvedAt]));
+                    setLastNonce(0);
+                }
+                // PoW solution was incorrect, move past the chunk
+                else {
+                    budget -= chunk;
+                    setLastNonce(lastNonce + chunk);
+                }
+            }
         }
         if (curChain->getChainSize() == 100) setExperimentOver(true);
     }
@@ -85,189 +215,380 @@ void BitcoinMiner::mineNext(const std::string newHash) {
         const std::string prevHash = (curLength > 1 ? splitHash(curChain->getBlockAt(curLength - 1).getHash()).getHash() : "-1_-1");
 
         curChain->createBlock(curLength, prevHash, newHash + ":" + std::to_string(solution), {_id}); // add to local blockchain
+        refreshPrefix();
         //std::cout << "Block " << curLength << " has been mined by " << _id << ":\t" << prevHash << " -> " << newHash << "\n";
 
         transmitBlock(); // send to other miners
     }
 }
 
+// Catch ups with fewer blocks than this to hash are verified on the calling thread
+static const int PARALLEL_VERIFY_MIN = 64;
+
+// Pool a catch up's first pass is split over, one miner at a time uses it. When the network already
+// steps miners in parallel the others verify on their own thread.
+static std::mutex& verifyPoolLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+static std::unique_ptr<ThreadPool>& verifyPool() {
+    static std::unique_ptr<ThreadPool> pool;
+    return pool;
+}
+
+void BitcoinMiner::setVerifyThreads(const int threads) {
+    std::lock_guard<std::mutex> guard(verifyPoolLock());
+    verifyPool().reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+}
+
 void BitcoinMiner::catchUpAndVerify(Blockchain* overtaker) {
     const int OVERTAKER_LENGTH = overtaker->getChainSize();
-    int blocksBehind = OVERTAKER_LENGTH - curChain->getChainSize();
-    int curPos = OVERTAKER_LENGTH - blocksBehind - 1;
-    int prevPos = curPos - 1;
 
-    if (blocksBehind > 0) {
+    if (OVERTAKER_LENGTH > curChain->getChainSize()) {
         setBeaten(true);
         setLastNonce(0);
-    }
 
-    while (blocksBehind > 0) {
-        int curPos = OVERTAKER_LENGTH - blocksBehind - 1;
-        if (curPos == 0) ++curPos;
-        int prevPos = curPos - 1;
-        std::string minerId = *(overtaker->getBlockAt(curPos).getPublishers().begin());
-
-        const splitHash curSplit = (curPos > 0 ? splitHash(overtaker->getBlockAt(curPos).getHash()) : splitHash(-1, "genesisHash"));
-        const splitHash prevSplit = (prevPos > 0 ? splitHash(overtaker->getBlockAt(prevPos).getHash()) : splitHash());
-        
-        std::string curHashCheck;
-
-        if (curPos == 0 || prevSplit.getHash() == "-1_-1") curHashCheck = "genesisHash";
-        else picosha2::hash256_hex_string(prevSplit.getHash() + minerId + std::to_string(curSplit.getNonce()), curHashCheck);
-
-        if ((curSplit.getHash() != curHashCheck) || (prevSplit.getHash() != overtaker->getBlockAt(curPos).getPreviousHash().substr(0, 64))) {
-            // This miner is on a fork - search from start of local chain for first mismatch and recreate the known good part of the chain.
-            int forkPos = 0;
-            Blockchain* validated = new Blockchain(false);
-            while (forkPos != curChain->getChainSize()) {
-                Block longer = overtaker->getBlockAt(forkPos);
-                Block local = curChain->getBlockAt(forkPos);
-                if ((longer.getHash() == local.getHash()) && longer.getPreviousHash() == local.getPreviousHash()) {
-                    std::string curHash, prevHash, miner;
-                    if (forkPos == 0) {
-                        curHash = "genesisHash";
-                        prevHash = "-1_-1";
-                        miner = "";
-                    }
-                    else {
-                        Block copyBlock(overtaker->getBlockAt(forkPos));
-                        curHash = copyBlock.getHash();
-                        prevHash = copyBlock.getPreviousHash();
-                        miner = *(overtaker->getBlockAt(forkPos).getPublishers().begin());
-                    }
-                    validated->createBlock(validated->getChainSize(), prevHash, curHash, {miner});
-                    ++forkPos;
-                }
-                else break;
+        // Blocks both chains hold are the same nodes in the block store, so the fork is their last common
+        // ancestor. The local chain is cut back to it and only the overtaker's blocks past it are verified.
+        const BlockNode* fork = BlockNode::lastCommonAncestor(curChain->getTip().get(), overtaker->getTip().get());
+        const int forkPos = (fork == nullptr ? 0 : fork->height() + 1);
+        curChain->truncate(forkPos);
+
+        // First pass: each block's proof of work only needs the block itself. Blocks no miner has verified
+        // yet get their midstate from this miner's cache here, then their hashes are split over the
+        // verification pool as one batch per chunk
+        const int MISSING = OVERTAKER_LENGTH - forkPos;
+        std::vector<const Block*> verifying(MISSING);
+        std::vector<splitHash> verifySplits(MISSING);
+        std::vector<std::string> prevVerifyHashes(MISSING);
+        std::vector<std::string> verifyIds(MISSING);
+        std::vector<char> hashValid(MISSING, 0);
+        std::vector<int> toHash;
+        std::vector<Digest> claimed;
+        std::vector<Sha256Prefix> prefixes;
+        std::vector<long long> nonces;
+        for (int k = 0; k < MISSING; ++k) {
+            const int verifyPos = forkPos + k;
+            verifying[k] = &overtaker->getBlockAt(verifyPos);
+            verifyIds[k] = (verifying[k]->getPublishers().empty() ? "" : *verifying[k]->getPublishers().begin());
+            verifySplits[k] = (verifyPos == 0 ? splitHash(-1, "genesisHash") : splitHash(verifying[k]->getHash()));
+            prevVerifyHashes[k] = (verifyPos < 2 ? "-1_-1" : splitHash(verifying[k]->getPreviousHash()).getHash());
+
+            Digest digest;
+            if (verifyPos == 0 || prevVerifyHashes[k] == "-1_-1") hashValid[k] = verifySplits[k].getHash() == "genesisHash";
+            else if (!digestFromHex(verifySplits[k].getHash(), digest)) hashValid[k] = false;
+            else if (verificationCache().contains(digest, prevVerifyHashes[k], verifyIds[k], verifySplits[k].getNonce())) hashValid[k] = true;
+            else {
+                toHash.push_back(k);
+                claimed.push_back(digest);
+                prefixes.push_back(midstateFor(prevVerifyHashes[k]).extended(verifyIds[k]));
+                nonces.push_back(verifySplits[k].getNonce());
             }
-            delete curChain;
-            curChain = new Blockchain(true);
-            setCurChain(*validated);
-            delete validated;
-
-            // Independently verify all the missed blocks
-            for (int verifyPos = forkPos; verifyPos != OVERTAKER_LENGTH; ++verifyPos) {
-                int prevVerifyPos = verifyPos - 1;
-                std::string verifyId = *(overtaker->getBlockAt(verifyPos).getPublishers().begin());
-                
-                const splitHash verifySplit = (verifyPos == 0 ? splitHash(-1, "genesisHash") : splitHash(overtaker->getBlockAt(verifyPos).getHash()));
-                const std::string prevVerifyHash = (verifyPos < 2 ? "-1_-1" : splitHash(overtaker->getBlockAt(verifyPos).getPreviousHash()).getHash());
-
-                std::string verifyHash;
-                
-                if (verifyPos == 0 || prevVerifyHash == "-1_-1") verifyHash = "genesisHash";
-                else picosha2::hash256_hex_string(prevVerifyHash + verifyId + std::to_string(verifySplit.getNonce()), verifyHash);
-
-                if ((verifySplit.getHash() == verifyHash) && (prevVerifyHash == overtaker->getBlockAt(verifyPos).getPreviousHash().substr(0, 64))) {
-                    curChain->createBlock(curChain->getChainSize(), prevVerifyHash, verifySplit.getHash() + ":" + std::to_string(verifySplit.getNonce()), {verifyId});
-                    //std::cerr << "\n" << _id << "(A) verified block " << curChain->getChainSize() - 1 << "\t" << prevVerifyHash << " -> " << verifyHash << "\n";
-                    --blocksBehind;
-                }
-                else {
-                    std::cerr << "\t\tH(" << prevVerifyHash << ", " << verifyId << ", " << std::to_string(verifySplit.getNonce()) << ") =\t" << verifyHash << "\n";
-                    std::cerr << "\t\tCurs\t" << verifySplit.getHash() << "\t" << verifyHash << "\n";
-                    std::cerr << "\t\tPrevs\t" << prevVerifyHash << "\t" <<  overtaker->getBlockAt(verifyPos).getPreviousHash().substr(0, 64) << "\n";
-                    std::cerr << "FORK RESOLUTION FAILED - EXITING\n";
-                    exit(EXIT_FAILURE);
-                    break;
-                }
-            }
-            break;
         }
-        else if ((curSplit.getHash() == curHashCheck) && (prevSplit.getHash() == overtaker->getBlockAt(curPos).getPreviousHash().substr(0, 64))) {
-            curChain->createBlock(curChain->getChainSize(), prevSplit.getHash(), curSplit.getHash() + ":" + std::to_string(curSplit.getNonce()), {minerId});
-            //std::cerr << "\n" << _id << "(B) verified block " << curChain->getChainSize() - 1 << "\t" << prevSplit.getHash() << " -> " << curSplit.getHash() << "\n";
-            --blocksBehind;
+        const int HASHING = (int)toHash.size();
+        std::vector<Digest> computed(HASHING);
+        auto hashRange = [&](int begin, int end, int) {
+            sha256Messages(prefixes.data() + begin, nonces.data() + begin, end - begin, computed.data() + begin);
+        };
+        std::unique_lock<std::mutex> poolGuard(verifyPoolLock(), std::defer_lock);
+        if (HASHING >= PARALLEL_VERIFY_MIN && poolGuard.try_lock() && verifyPool() != nullptr) verifyPool()->parallelFor(HASHING, hashRange);
+        else hashRange(0, HASHING, 0);
+        if (poolGuard.owns_lock()) poolGuard.unlock();
+        for (int i = 0; i < HASHING; ++i) {
+            const int k = toHash[i];
+            hashValid[k] = computed[i] == claimed[i];
+            if (hashValid[k]) verificationCache().insert(claimed[i], prevVerifyHashes[k], verifyIds[k], verifySplits[k].getNonce());
         }
-        else {
-            std::cerr << "FATAL ERROR - Catch up and verify. No conditions matched. Exiting.\n";
-            exit(EXIT_FAILURE);
+
+        // Second pass: in order, each block has to build on the one below it, not only on the hash it claims
+        for (int k = 0; k < MISSING; ++k) {
+            const int verifyPos = forkPos + k;
+            const std::string& prevVerifyHash = prevVerifyHashes[k];
+            const std::string parentHash = (verifyPos < 2 ? "-1_-1" : splitHash(overtaker->getBlockAt(verifyPos - 1).getHash()).getHash());
+
+            if (hashValid[k] && prevVerifyHash == parentHash && (prevVerifyHash == verifying[k]->getPreviousHash().substr(0, 64))) {
+                // added whole so the store hands back the overtaker's own node
+                curChain->createBlock(curChain->getChainSize(), verifying[k]->getPreviousHash(), verifying[k]->getHash(), verifying[k]->getPublishers());
+                //std::cerr << "\n" << _id << " verified block " << curChain->getChainSize() - 1 << "\t" << prevVerifyHash << " -> " << verifySplits[k].getHash() << "\n";
+            }
+            else {
+                const bool genesis = verifyPos == 0 || prevVerifyHash == "-1_-1";
+                const std::string verifyHash = (genesis ? "genesisHash" : blockSHA(prevVerifyHash, verifyIds[k], verifySplits[k].getNonce()));
+                std::cerr << "\t\tH(" << prevVerifyHash << ", " << verifyIds[k] << ", " << std::to_string(verifySplits[k].getNonce()) << ") =\t" << verifyHash << "\n";
+                std::cerr << "\t\tCurs\t" << verifySplits[k].getHash() << "\t" << verifyHash << "\n";
+                std::cerr << "\t\tPrevs\t" << prevVerifyHash << "\t" <<  verifying[k]->getPreviousHash().substr(0, 64) << "\t" << parentHash << "\n";
+                std::cerr << "FORK RESOLUTION FAILED - EXITING\n";
+                exit(EXIT_FAILURE);
+            }
         }
     }
+    refreshPrefix();
 }
 
-// Checks for solutions from other miners.
+// Answers and acts on the relay messages that arrived this round.
 void BitcoinMiner::readBlock() {
     receive(); // refresh instream
-    int longestChainLength = curChain->getChainSize();
-    const int LOCAL_SIZE = curChain->getChainSize();
-
-    // Stores position of message with longest corresponding blockchain
-    int longestChainAt = -1;
-
-    // Find longest blockchain
     for (int i = 0; i < _inStream.size(); ++i) {
-        const BitcoinMessage RECEIVED_MSG = _inStream[i].getMessage();
-        const int RECEIVED_LENGTH = RECEIVED_MSG.length; // blockchain length
-        const std::string senderId = _inStream[i].getMessage().peerId;
-        if (RECEIVED_LENGTH > LOCAL_SIZE && RECEIVED_LENGTH > longestChainLength) {
-            longestChainAt = i;
-            longestChainLength = RECEIVED_LENGTH;
-        }
-        else if (RECEIVED_LENGTH == LOCAL_SIZE && senderId != _id && (findMiner(senderId)->getCurChain()->getBlockAt(findMiner(senderId)->getCurChain()->getChainSize() - 1).getHash() != curChain->getBlockAt(curChain->getChainSize() - 1).getHash())) {
-            competitors.push_back(findMiner(senderId));
+        const BitcoinMessage &msg = _inStream[i].getMessage();
+        LinkTraffic &link = traffic[msg.peerId];
+        link.bytesReceived += msg.size();
+        ++link.messagesReceived;
+        // an inv is the sender's tip, headers and blocks come off its chain
+        int &known = peerHeights[msg.peerId];
+        for (const BlockRef& ref : msg.refs) if (msg.type == INV) known = std::max(known, ref.height);
+        for (const Block& block : msg.blocks) known = std::max(known, block.getIndex());
+
+        if (msg.type == INV) readInv(msg);
+        else if (msg.type == GET_HEADERS) sendHeaders(msg);
+        else if (msg.type == HEADERS) readHeaders(msg);
+        else if (msg.type == GET_DATA) sendBlocks(msg);
+        else if (msg.type == BLOCK) readBlocks(msg);
+    }
+    _inStream.clear();
+}
+
+// An announced block past our tip is fetched. The next block is asked for straight away, further
+// ahead the announcer's headers are needed first to find where its chain leaves ours.
+void BitcoinMiner::readInv(const BitcoinMessage& msg) {
+    for (const BlockRef& ref : msg.refs) {
+        // a chain no longer than ours loses to the one we saw first
+        if (ref.height < curChain->getChainSize() || awaiting(blocksAsked, ref.hash)) continue;
+        if (ref.height == curChain->getChainSize()) {
+            BitcoinMessage request(GET_DATA, _id);
+            request.refs.push_back(ref);
+            blocksAsked[ref.hash] = requestDeadline(msg.peerId);
+            sendTo(msg.peerId, request);
         }
+        else askHeaders(msg.peerId);
     }
+}
 
-    // Check if a competitor has overtaken us
-    int longestCompetitorSize = -1;
-    int longestCompetitorNum = -1;
+// The headers answer covers the neighbor's whole chain, so one is asked for at a time
+void BitcoinMiner::askHeaders(const std::string& neighborId) {
+    if (awaiting(headersAsked, neighborId)) return;
+    BitcoinMessage request(GET_HEADERS, _id);
+    request.refs = locator();
+    headersAsked[neighborId] = requestDeadline(neighborId);
+    sendTo(neighborId, request);
+}
 
-    for (int competitorNum = 0; competitorNum < competitors.size(); ++competitorNum) {
-        int competitorSize = competitors.at(competitorNum)->getCurChain()->getChainSize();
-        if (competitorSize > LOCAL_SIZE && competitorSize > longestCompetitorSize) {
-            longestCompetitorSize = competitorSize;
-            longestCompetitorNum = competitorNum;
+// Headers after the last locator entry on this chain, block 0 is every miner's so a locator always has one.
+void BitcoinMiner::sendHeaders(const BitcoinMessage& msg) {
+    const int size = curChain->getChainSize();
+    int start = size;
+    for (const BlockRef& ref : msg.refs) {
+        if (ref.height < size && BlockRef(curChain->getBlockAt(ref.height)).hash == ref.hash) {
+            start = ref.height + 1;
+            break;
         }
     }
+    const int end = std::min(size, start + MAX_HEADERS);
+    if (start >= end) return;
+
+    BitcoinMessage reply(HEADERS, _id);
+    reply.blocks.resize(end - start);
+    const BlockNode* node = curChain->getTip()->ancestor(end - 1);
+    for (int height = end - 1; height >= start; --height, node = node->parent()) reply.blocks[height - start] = node->block();
+    sendTo(msg.peerId, reply);
+}
 
-    // Node has lost a fork race and will rebuild its chain up to the fork position, then verify the competitor's subsequent block(s)
-    if (longestCompetitorSize != -1) {
-        //std::cerr << _id << " catching up from " << LOCAL_SIZE - 1 << " to " << longestCompetitorSize - 1<< "(" << competitors.at(longestCompetitorNum)->id() << ")\n";
-        Blockchain* longestCompetitorChain = competitors.at(longestCompetitorNum)->getCurChain();
-        catchUpAndVerify(longestCompetitorChain);
-        competitors.clear();
+// Headers that build a longer chain off ours are checked before any block is fetched, then the
+// blocks not already here or on their way are asked for.
+void BitcoinMiner::readHeaders(const BitcoinMessage& msg) {
+    headersAsked.erase(msg.peerId);
+    // the locator they answer may be older than our tip, headers we hold already are dropped
+    int held = 0;
+    while (held < msg.blocks.size() && msg.blocks[held].getIndex() < curChain->getChainSize()
+        && BlockRef(curChain->getBlockAt(msg.blocks[held].getIndex())).hash == BlockRef(msg.blocks[held]).hash) ++held;
+    const std::vector<Block> headers(msg.blocks.begin() + held, msg.blocks.end());
+    if (headers.empty()) return;
+    const int forkHeight = headers.front().getIndex();
+    const int newLength = headers.back().getIndex() + 1;
+    if (newLength <= curChain->getChainSize() || forkHeight < 1 || forkHeight > curChain->getChainSize()) return;
+    // one download at a time, unless it stalled or this chain is longer
+    if (!pendingHeaders.empty() && pendingUntil > _clock && newLength <= pendingHeaders.back().getIndex() + 1) return;
+    if (!chainValid(curChain->getBlockAt(forkHeight - 1), headers)) return;
+
+    pendingHeaders = headers;
+    pendingUntil = requestDeadline(msg.peerId);
+    BitcoinMessage request(GET_DATA, _id);
+    for (const Block& header : headers) {
+        const BlockRef ref(header);
+        if (received.count(ref.hash) != 0 || awaiting(blocksAsked, ref.hash)) continue;
+        request.refs.push_back(ref);
+        blocksAsked[ref.hash] = pendingUntil;
     }
-    // If the longest chain received is longer than the peer's current chain,
-    // peer will verify each block that it is missing and add them to its chain.
-    else if (longestChainAt != -1) {
-        const Block topBlock = _inStream[longestChainAt].getMessage().block;
-        const BitcoinMiner* topNeighbor;
-        std::string lastHash = splitHash(curChain->getBlockAt(curChain->getChainSize() - 1).getHash()).getHash();
-        for (std::map<std::string, Peer<BitcoinMessage> *>::iterator it = _neighbors.begin(); it != _neighbors.end(); ++it) {
-            BitcoinMiner* neighbor = static_cast<BitcoinMiner*>(it->second);
-            std::string peerId = *(topBlock.getPublishers()).begin();
-
-            if (neighbor->id() == peerId) {
-                topNeighbor = neighbor;
-                break;
-            }
-        }
+    if (!request.refs.empty()) sendTo(msg.peerId, request);
+    connectPending();
+}
 
-        Blockchain* longestChain = topNeighbor->getCurChain();
-        int blocksBehind = longestChain->getChainSize() - curChain->getChainSize();
+// The asked for blocks still on this chain, one packet for the lot.
+void BitcoinMiner::sendBlocks(const BitcoinMessage& msg) {
+    BitcoinMessage reply(BLOCK, _id);
+    reply.blockBytes = blockBytes;
+    for (const BlockRef& ref : msg.refs) {
+        if (ref.height < curChain->getChainSize() && BlockRef(curChain->getBlockAt(ref.height)).hash == ref.hash) reply.blocks.push_back(curChain->getBlockAt(ref.height));
+    }
+    if (!reply.blocks.empty()) sendTo(msg.peerId, reply);
+}
 
-        // Catch up and verify each block along the way
-        if (blocksBehind > 0) catchUpAndVerify(longestChain); 
+// Blocks are held until the chain they belong to can be adopted. One that builds on our tip is
+// adopted right away, one that does not is on a branch we have not seen and its headers are asked for.
+void BitcoinMiner::readBlocks(const BitcoinMessage& msg) {
+    for (const Block& block : msg.blocks) {
+        const BlockRef ref(block);
+        blocksAsked.erase(ref.hash);
+        received[ref.hash] = block;
+    }
+    connectPending();
+    for (const Block& block : msg.blocks) {
+        const BlockRef ref(block);
+        const int size = curChain->getChainSize();
+        if (received.count(ref.hash) == 0 || block.getIndex() < size || inPending(ref)) continue;
+        if (block.getIndex() == size && blockValid(block, curChain->getBlockAt(size - 1))) adopt({block});
+        else askHeaders(msg.peerId);
     }
-    _inStream.clear();
 }
 
-// Send block to other miners
-void BitcoinMiner::transmitBlock() {
-    const int blockLength = curChain->getChainSize();
-    Block newBlock = curChain->getBlockAt(blockLength - 1);
+bool BitcoinMiner::inPending(const BlockRef& ref) const {
+    if (pendingHeaders.empty()) return false;
+    const int offset = ref.height - pendingHeaders.front().getIndex();
+    return offset >= 0 && offset < pendingHeaders.size() && BlockRef(pendingHeaders[offset]).hash == ref.hash;
+}
 
-    BitcoinMessage toSend(newBlock, _id, blockLength);
+void BitcoinMiner::connectPending() {
+    if (pendingHeaders.empty()) return;
+    std::vector<Block> blocks;
+    for (const Block& header : pendingHeaders) {
+        auto block = received.find(BlockRef(header).hash);
+        if (block == received.end()) return;
+        blocks.push_back(block->second);
+    }
+    pendingHeaders.clear();
+    // our chain may have moved while the blocks were on their way
+    const int forkHeight = blocks.front().getIndex();
+    if (forkHeight <= curChain->getChainSize() && chainValid(curChain->getBlockAt(forkHeight - 1), blocks)) adopt(blocks);
+}
+
+// blocks have been checked against the chain they extend, they start at most one past our tip
+void BitcoinMiner::adopt(const std::vector<Block>& blocks) {
+    if (blocks.back().getIndex() + 1 <= curChain->getChainSize()) return;
+    Blockchain candidate = *curChain;
+    candidate.truncate(blocks.front().getIndex());
+    for (const Block& block : blocks) candidate.createBlock(block.getIndex(), block.getPreviousHash(), block.getHash(), block.getPublishers());
+    catchUpAndVerify(&candidate);
+
+    // what is below the new tip is on this chain or on a branch that lost
+    for (auto block = received.begin(); block != received.end();) {
+        if (block->second.getIndex() < curChain->getChainSize()) block = received.erase(block);
+        else ++block;
+    }
+    for (auto request = blocksAsked.begin(); request != blocksAsked.end();) {
+        if (request->second <= _clock) request = blocksAsked.erase(request);
+        else ++request;
+    }
+    transmitBlock(); // relay the new tip
+}
 
-    for (auto it = _neighbors.begin(); it != _neighbors.end(); ++it) {
-        std::string neighborId = it->first;
-        Packet<BitcoinMessage> msgPacket("", neighborId, _id);
-        msgPacket.setBody(toSend);
-        _outStream.push_back(msgPacket);
+bool BitcoinMiner::blockValid(const Block& block, const Block& parent) {
+    if (block.getIndex() != parent.getIndex() + 1) return false;
+    const splitHash split(block.getHash());
+    if (block.getIndex() < 2) return split.getHash() == "genesisHash";
+    // the same checks catchUpAndVerify makes
+    const std::string prevHash = splitHash(block.getPreviousHash()).getHash();
+    const std::string minerId = (block.getPublishers().empty() ? "" : *block.getPublishers().begin());
+    return prevHash == splitHash(parent.getHash()).getHash() && prevHash == block.getPreviousHash().substr(0, 64) && hashMatches(split.getHash(), prevHash, minerId, split.getNonce());
+}
+
+bool BitcoinMiner::chainValid(const Block& parent, const std::vector<Block>& blocks) {
+    for (int i = 0; i < blocks.size(); ++i) {
+        if (!blockValid(blocks[i], i == 0 ? parent : blocks[i - 1])) return false;
+    }
+    return true;
+}
+
+std::vector<BlockRef> BitcoinMiner::locator() const {
+    std::vector<BlockRef> refs;
+    const BlockNode* tip = curChain->getTip().get();
+    if (tip == nullptr) return refs;
+    int step = 1;
+    for (int height = tip->height(); height > 0; height -= step) {
+        refs.push_back(BlockRef(tip->ancestor(height)->block()));
+        if (refs.size() >= 10) step *= 2;
+    }
+    refs.push_back(BlockRef(tip->ancestor(0)->block()));
+    return refs;
+}
+
+// Answers take a round trip over the link plus whatever is queued ahead of them, a request still
+// unanswered after this many round trips is given up on and can be sent again.
+static const int REQUEST_ROUND_TRIPS = 4;
+
+int BitcoinMiner::requestDeadline(const std::string& neighborId) const {
+    return _clock + REQUEST_ROUND_TRIPS * 2 * (getDelayToNeighbor(neighborId) + 1);
+}
+
+bool BitcoinMiner::awaiting(const std::map<std::string, int>& asked, const std::string& key) const {
+    auto request = asked.find(key);
+    return request != asked.end() && request->second > _clock;
+}
+
+void BitcoinMiner::sendTo(const std::string& neighborId, const BitcoinMessage& msg) {
+    auto neighbor = _neighbors.find(neighborId);
+    if (neighbor == _neighbors.end()) return;
+    Packet<BitcoinMessage> packet(0, neighbor->second->index(), _index);
+    packet.setBody(msg);
+    _outStream.push_back(packet);
+    countSent(neighborId, msg);
+}
+
+void BitcoinMiner::countSent(const std::string& neighborId, const BitcoinMessage& msg) {
+    LinkTraffic &link = traffic[neighborId];
+    link.bytesSent += msg.size();
+    ++link.messagesSent;
+    sentByType[msg.type] += msg.size();
+}
+
+const LinkTraffic& BitcoinMiner::linkTraffic(const std::string& neighborId) const {
+    static const LinkTraffic idle;
+    auto link = traffic.find(neighborId);
+    return (link == traffic.end() ? idle : link->second);
+}
+
+long long BitcoinMiner::bytesSent() const {
+    long long total = 0;
+    for (auto link = traffic.begin(); link != traffic.end(); ++link) total += link->second.bytesSent;
+    return total;
+}
+
+long long BitcoinMiner::bytesReceived() const {
+    long long total = 0;
+    for (auto link = traffic.begin(); link != traffic.end(); ++link) total += link->second.bytesReceived;
+    return total;
+}
+
+long long BitcoinMiner::bytesSent(const std::string& type) const {
+    auto sent = sentByType.find(type);
+    return (sent == sentByType.end() ? 0 : sent->second);
+}
+
+// Announce the new tip to other miners, they fetch what they are missing. A neighbor known to hold a
+// chain at least as long would ignore the inv, so it is not sent one.
+void BitcoinMiner::transmitBlock() {
+    BitcoinMessage announce(INV, _id);
+    announce.refs.push_back(BlockRef(curChain->getBlockAt(curChain->getChainSize() - 1)));
+
+    Packet<BitcoinMessage> msgPacket(0);
+    msgPacket.setBody(announce);
+    std::map<std::string, Peer<BitcoinMessage>*> targets;
+    for (auto neighbor = _neighbors.begin(); neighbor != _neighbors.end(); ++neighbor) {
+        auto known = peerHeights.find(neighbor->first);
+        if (known != peerHeights.end() && known->second >= announce.refs.front().height) continue;
+        targets.insert(*neighbor);
+        countSent(neighbor->first, announce);
     }
-    transmit();
+    multicast(msgPacket, targets);
 }
 
 void BitcoinMiner::makeRequest() {
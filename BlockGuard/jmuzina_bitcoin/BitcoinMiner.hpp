@@ -3,13 +3,30 @@
 
 #include "./../Common/Peer.hpp"
 #include "./../Common/Blockchain.hpp"
+#include "./../Common/ThreadPool.hpp"
 #include <stdlib.h>
 #include <time.h>
 #include "./BitcoinMessage.hpp"
 #include "picosha2.h"
+#include "Sha256Batch.hpp"
+#include "VerificationCache.hpp"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Relay traffic on one link, bytes as they would be on the wire
+struct LinkTraffic {
+    long long                       bytesSent = 0;
+    long long                       bytesReceived = 0;
+    int                             messagesSent = 0;
+    int                             messagesReceived = 0;
+};
 
 class BitcoinMiner : public Peer<BitcoinMessage> { // inherits from peer class
 public:
+    static const bool               PARALLEL_STEP = true; // chains come in messages, the block store and caches are locked
     // Attributes
     Blockchain*                     curChain; // This peer's version of the blockchain
 
@@ -18,29 +35,96 @@ public:
                                     ~BitcoinMiner           () override                 { delete curChain; };
     void                            mineNext                (const std::string);
     void                            catchUpAndVerify        (Blockchain* overtaker);
+    // threads the hashes of a long catch up are split over, shared by every miner (1 = the miner's own thread)
+    static void                     setVerifyThreads        (const int threads);
     void                            makeRequest             () override;
     void                            preformComputation      () override;
-    void                            readBlock               ();
-    void                            transmitBlock           ();
-    void                            setCurChain             (const Blockchain& setFrom) { *curChain = setFrom; };
+    void                            readBlock               (); // answers and acts on every relay message that arrived, the answers go out on transmit
+    void                            transmitBlock           (); // queues an INV of the tip for every neighbor
+    void                            setCurChain             (const Blockchain& setFrom) { *curChain = setFrom; refreshPrefix(); };
     void                            setBeaten               (const bool wasBeaten)      { beaten = wasBeaten; };
     bool                            getBeaten               () const                    { return beaten; };
     void                            setLastNonce            (long long nonce)           { lastNonce = nonce; };
     long long                       getLastNonce            () const                    { return lastNonce; };
     void                            setExperimentOver       (const bool set)            { experimentOver = set; };
     bool                            getExperimentOver       () const                    { return experimentOver; };
-    BitcoinMiner*                   findMiner               (const std::string);
     Blockchain*                     getCurChain             () const                    { return curChain; };
     std::string                     getId                   () const                    { return peerId; };
     std::string                     getSHA                  (long long) const;
+    void                            getSHA                  (long long first, int count, Digest* out) const; // hashes count nonces from first in one batch
+    Digest                          blockDigest             (const std::string& prevHash, const std::string& minerId, long long nonce); // hash a block claims, for verifying it
+    std::string                     blockSHA                (const std::string& prevHash, const std::string& minerId, long long nonce) { return digestHex(blockDigest(prevHash, minerId, nonce)); };
+    bool                            hashMatches             (const std::string& claimedHex, const std::string& prevHash, const std::string& minerId, long long nonce);
+    void                            setDifficulty           (const int zeroBits)        { target = zeroBitsTarget(zeroBits); }; // leading zero bits a solution needs
+    void                            setTarget               (const Digest& threshold)   { target = threshold; }; // largest digest that solves a block
+    const Digest&                   getTarget               () const                    { return target; };
+    void                            setHashRate             (const long long hashes)    { hashRate = hashes; solveHash = -1; }; // nonces tried per round, miners can differ
+    long long                       getHashRate             () const                    { return hashRate; };
+    // sampled mining draws the hash a block is found at instead of hashing up to it, blocks come as
+    // often as real mining for the same hash rate and target but cost O(1) each
+    void                            setSampledMining        (const bool sampled)        { sampledMining = sampled; solveHash = -1; };
+    bool                            getSampledMining        () const                    { return sampledMining; };
+    // with sampled mining, still hash for a nonce that meets the target when a block is due (spot checks)
+    void                            setRealHashing          (const bool real)           { realHashing = real; };
+    bool                            getRealHashing          () const                    { return realHashing; };
+    int                             nextWakeup              () const override; // sampled miners sleep until their next block
+    void                            setBlockSize            (const int bytes)           { blockBytes = std::max(bytes, BLOCK_HEADER_BYTES); }; // whole block on the wire
+    int                             getBlockSize            () const                    { return blockBytes; };
+    // relay bandwidth, per neighbor and in total, in wire bytes
+    const LinkTraffic&              linkTraffic             (const std::string& neighborId) const;
+    long long                       bytesSent               () const;
+    long long                       bytesReceived           () const;
+    long long                       bytesSent               (const std::string& type) const; // of one message type
+    void                            resetTraffic            ()                          { traffic.clear(); sentByType.clear(); };
 
 private:
     std::string                     peerId;
     std::string                     foundHash;
     long long                       lastNonce;
+    long long                       hashRate; // nonces tried per preformComputation
+    std::vector<Digest>             attempts; // scratch for one chunk of the hash budget
+    Digest                          target; // proof of work threshold, 12 zero bits ("000" in hex) by default
+    bool                            sampledMining;
+    bool                            realHashing;
+    long long                       solveHash; // sampled mining: hash the next block is found at, round r tries hashes [r * hashRate, (r + 1) * hashRate), -1 to draw again
+    long long                       solveAttempts; // sampled mining: hashes the current tip takes, the drawn stand in for the winning nonce + 1
     bool                            experimentOver;
     bool                            beaten;
-    std::vector<BitcoinMiner*>      competitors;
+    int                             blockBytes;
+    std::map<std::string, LinkTraffic> traffic; // by neighbor id
+    std::map<std::string, long long> sentByType;
+    std::map<std::string, int>      peerHeights; // highest block each neighbor has shown it holds
+    // relay requests, mapped to the round they are given up on
+    std::map<std::string, int>      headersAsked; // neighbors a GET_HEADERS went out to
+    std::map<std::string, int>      blocksAsked; // blocks a GET_DATA went out for, by ref hash
+    std::map<std::string, Block>    received; // blocks that arrived ahead of the chain they belong to
+    std::vector<Block>              pendingHeaders; // checked headers of the longer chain being downloaded
+    int                             pendingUntil; // round the download is given up on
+    // midstates of prevHash, shared by mining on a tip and verifying the blocks built on it
+    std::map<std::string, Sha256Prefix> midstates;
+    Sha256Prefix                    miningPrefix; // midstate of the current tip's hash + _id
+    std::string                     miningTip; // hash of the tip miningPrefix is for
+
+    const Sha256Prefix&             midstateFor             (const std::string& prevHash);
+    void                            refreshPrefix           (); // call whenever the tip changes
+    long long                       attemptsUntilSolved     (); // hashes up to and including the next solution, geometric in the target's odds
+    void                            mineSampled             (long long nonce); // mines the current tip without the search
+    void                            sendTo                  (const std::string& neighborId, const BitcoinMessage& msg);
+    void                            countSent               (const std::string& neighborId, const BitcoinMessage& msg);
+    int                             requestDeadline         (const std::string& neighborId) const;
+    bool                            awaiting                (const std::map<std::string, int>& asked, const std::string& key) const;
+    std::vector<BlockRef>           locator                 () const; // tip back to genesis in doubling steps
+    bool                            blockValid              (const Block& block, const Block& parent); // proof of work and linkage
+    bool                            chainValid              (const Block& parent, const std::vector<Block>& blocks);
+    void                            adopt                   (const std::vector<Block>& blocks); // switches to the chain they extend, if it is longer
+    void                            askHeaders              (const std::string& neighborId);
+    void                            readInv                 (const BitcoinMessage& msg);
+    void                            sendHeaders             (const BitcoinMessage& msg);
+    void                            readHeaders             (const BitcoinMessage& msg);
+    void                            sendBlocks              (const BitcoinMessage& msg);
+    void                            readBlocks              (const BitcoinMessage& msg);
+    bool                            inPending               (const BlockRef& ref) const; // one of the blocks being downloaded
+    void                            connectPending          (); // adopts the download once every block is in
 };
 
 #endif 
\ No newline at end of file
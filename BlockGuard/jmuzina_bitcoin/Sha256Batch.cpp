@@ -0,0 +1,447 @@
+#include "Sha256Batch.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// the SIMD kernels are compiled for their own target and only called after cpuid says the CPU
+// has the instructions, so the rest of the build needs no -m flags
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_X86_KERNELS
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+static const uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+enum ShaKernel {SCALAR_KERNEL, AVX2_KERNEL, SHA_NI_KERNEL};
+
+static inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static inline uint32_t loadBigEndian(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void storeDigest(const uint32_t state[8], Digest &out) {
+    for (int i = 0; i < 8; ++i) {
+        out[4 * i] = (uint8_t)(state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)state[i];
+    }
+}
+
+// number of 64 byte blocks a message of length bytes pads out to
+static int blocksFor(size_t length) { return (int)((length + 9 + 63) / 64); }
+
+// writes nonce in decimal (as std::to_string does) at out and returns how many bytes it took
+static int writeDigits(long long nonce, uint8_t *out) {
+    char digits[20];
+    int length = 0;
+    unsigned long long magnitude = nonce < 0 ? 0ULL - (unsigned long long)nonce : (unsigned long long)nonce;
+    do {
+        digits[length++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    int written = 0;
+    if (nonce < 0) out[written++] = '-';
+    while (length > 0) out[written++] = (uint8_t)digits[--length];
+    return written;
+}
+
+// one lane's padded message after the prefix's midstate, the prefix's tail is written once and
+// each nonce only rewrites the digits and padding
+struct NonceMessage {
+    std::vector<uint8_t>    buffer;
+    size_t                  tailLength;
+    uint64_t                compressed;
+    int                     blocks;
+
+    void init(const Sha256Prefix &prefix) {
+        tailLength = prefix.tail().size();
+        compressed = prefix.compressed();
+        buffer.assign(blocksFor(tailLength + 20) * 64, 0); // room for a sign and 19 digits
+        std::memcpy(buffer.data(), prefix.tail().data(), tailLength);
+        blocks = 0;
+    }
+
+    void setNonce(long long nonce) {
+        const size_t length = tailLength + writeDigits(nonce, buffer.data() + tailLength);
+        blocks = blocksFor(length);
+        const size_t end = blocks * 64;
+        buffer[length] = 0x80;
+        std::memset(buffer.data() + length + 1, 0, end - length - 9);
+        const uint64_t bits = (compressed + length) * 8;
+        for (int i = 0; i < 8; ++i) buffer[end - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+};
+
+static void compressScalar(uint32_t state[8], const uint8_t *data, int blocks) {
+    uint32_t w[64];
+    for (; blocks > 0; --blocks, data += 64) {
+        for (int t = 0; t < 16; ++t) w[t] = loadBigEndian(data + 4 * t);
+        for (int t = 16; t < 64; ++t) {
+            const uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            const uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + ROUND_CONSTANTS[t] + w[t];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef SHA256_X86_KERNELS
+
+static bool cpuHasAvx2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28))) return false; // OSXSAVE and AVX
+    unsigned int xcr0, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+    if ((xcr0 & 6) != 6) return false; // the OS saves the ymm registers
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    return ebx & (1u << 5);
+}
+
+static bool cpuHasShaNi() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & (1u << 9)) || !(ecx & (1u << 19))) return false; // SSSE3 and SSE4.1
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    return ebx & (1u << 29);
+}
+
+#define AVX2_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// hashes SHA_LANES messages of the same block count side by side, lane j of each register is message j
+// continuing from midstates[j]
+__attribute__((target("avx2")))
+static void hashLanesAvx2(const uint32_t *const midstates[SHA_LANES], const NonceMessage *const lanes[SHA_LANES], Digest *out) {
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i) {
+        state[i] = _mm256_set_epi32((int)midstates[7][i], (int)midstates[6][i], (int)midstates[5][i], (int)midstates[4][i],
+                                    (int)midstates[3][i], (int)midstates[2][i], (int)midstates[1][i], (int)midstates[0][i]);
+    }
+    __m256i w[16];
+    for (int block = 0; block < lanes[0]->blocks; ++block) {
+        const int offset = block * 64;
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            __m256i word;
+            if (t < 16) {
+                word = _mm256_set_epi32(
+                    (int)loadBigEndian(lanes[7]->buffer.data() + offset + 4 * t), (int)loadBigEndian(lanes[6]->buffer.data() + offset + 4 * t),
+                    (int)loadBigEndian(lanes[5]->buffer.data() + offset + 4 * t), (int)loadBigEndian(lanes[4]->buffer.data() + offset + 4 * t),
+                    (int)loadBigEndian(lanes[3]->buffer.data() + offset + 4 * t), (int)loadBigEndian(lanes[2]->buffer.data() + offset + 4 * t),
+                    (int)loadBigEndian(lanes[1]->buffer.data() + offset + 4 * t), (int)loadBigEndian(lanes[0]->buffer.data() + offset + 4 * t));
+            }
+            else {
+                const __m256i w15 = w[(t - 15) & 15];
+                const __m256i w2 = w[(t - 2) & 15];
+                const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w15, 7), AVX2_ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+                const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w2, 17), AVX2_ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+                word = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+            }
+            w[t & 15] = word;
+            const __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(e, 6), AVX2_ROTR(e, 11)), AVX2_ROTR(e, 25));
+            const __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, bigSigma1), _mm256_add_epi32(choose, word)),
+                                                _mm256_set1_epi32((int)ROUND_CONSTANTS[t]));
+            const __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(a, 2), AVX2_ROTR(a, 13)), AVX2_ROTR(a, 22));
+            const __m256i majority = _mm256_or_si256(_mm256_and_si256(a, _mm256_or_si256(b, c)), _mm256_and_si256(b, c));
+            const __m256i t2 = _mm256_add_epi32(bigSigma0, majority);
+            h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+            d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+        }
+        state[0] = _mm256_add_epi32(state[0], a); state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c); state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e); state[5] = _mm256_add_epi32(state[5], f);
+        state[6] = _mm256_add_epi32(state[6], g); state[7] = _mm256_add_epi32(state[7], h);
+    }
+    uint32_t words[8][SHA_LANES];
+    for (int i = 0; i < 8; ++i) _mm256_storeu_si256((__m256i*)words[i], state[i]);
+    for (int lane = 0; lane < SHA_LANES; ++lane) {
+        uint32_t laneState[8];
+        for (int i = 0; i < 8; ++i) laneState[i] = words[i][lane];
+        storeDigest(laneState, out[lane]);
+    }
+}
+
+// the SHA extensions keep the state as ABEF/CDGH and do two rounds per instruction
+__attribute__((target("sha,sse4.1,ssse3")))
+static void compressShaNi(uint32_t state[8], const uint8_t *data, int blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1); // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B); // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i savedAbef = state0;
+        const __m128i savedCdgh = state1;
+        __m128i message[4];
+        for (int group = 0; group < 16; ++group) {
+            __m128i words;
+            if (group < 4) {
+                words = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * group)), byteSwap);
+            }
+            else {
+                const __m128i last = message[(group - 1) & 3];
+                words = _mm_sha256msg1_epu32(message[group & 3], message[(group - 3) & 3]);
+                words = _mm_add_epi32(words, _mm_alignr_epi8(last, message[(group - 2) & 3], 4));
+                words = _mm_sha256msg2_epu32(words, last);
+            }
+            message[group & 3] = words;
+            __m128i rounds = _mm_add_epi32(words, _mm_loadu_si128((const __m128i*)&ROUND_CONSTANTS[4 * group]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, rounds);
+            rounds = _mm_shuffle_epi32(rounds, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, rounds);
+        }
+        state0 = _mm_add_epi32(state0, savedAbef);
+        state1 = _mm_add_epi32(state1, savedCdgh);
+    }
+    tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8); // ABEF
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+#else
+
+static bool cpuHasAvx2() { return false; }
+static bool cpuHasShaNi() { return false; }
+
+#endif
+
+static int bestKernel() {
+    if (cpuHasShaNi()) return SHA_NI_KERNEL;
+    if (cpuHasAvx2()) return AVX2_KERNEL;
+    return SCALAR_KERNEL;
+}
+
+static std::atomic<int>& activeKernel() {
+    static std::atomic<int> kernel(bestKernel());
+    return kernel;
+}
+
+// compresses whole blocks into state with the fastest single message kernel allowed
+static void compressBlocks(int kernel, uint32_t state[8], const uint8_t *data, int blocks) {
+#ifdef SHA256_X86_KERNELS
+    if (kernel == SHA_NI_KERNEL) {
+        compressShaNi(state, data, blocks);
+        return;
+    }
+#endif
+    compressScalar(state, data, blocks);
+}
+
+static void hashOne(int kernel, const uint32_t midstate[8], const NonceMessage &message, Digest &out) {
+    uint32_t state[8];
+    std::memcpy(state, midstate, sizeof(state));
+    compressBlocks(kernel, state, message.buffer.data(), message.blocks);
+    storeDigest(state, out);
+}
+
+Sha256Prefix::Sha256Prefix() {
+    std::memcpy(_state, INITIAL_STATE, sizeof(_state));
+    _compressed = 0;
+}
+
+Sha256Prefix::Sha256Prefix(const std::string &prefix) {
+    std::memcpy(_state, INITIAL_STATE, sizeof(_state));
+    _compressed = 0;
+    *this = extended(prefix);
+}
+
+Sha256Prefix Sha256Prefix::extended(const std::string &more) const {
+    Sha256Prefix longer(*this);
+    longer._tail += more;
+    const int blocks = (int)(longer._tail.size() / 64);
+    if (blocks > 0) {
+        compressBlocks(activeKernel().load(), longer._state, (const uint8_t*)longer._tail.data(), blocks);
+        longer._compressed += blocks * 64;
+        longer._tail.erase(0, blocks * 64);
+    }
+    return longer;
+}
+
+void sha256Nonces(const std::string &prefix, long long first, int count, Digest *out) {
+    sha256Nonces(Sha256Prefix(prefix), first, count, out);
+}
+
+void sha256Nonces(const Sha256Prefix &prefix, long long first, int count, Digest *out) {
+    if (count <= 0) return;
+    const int kernel = activeKernel().load();
+    NonceMessage lanes[SHA_LANES];
+    const int lanesUsed = (kernel == AVX2_KERNEL && count >= SHA_LANES) ? SHA_LANES : 1;
+    for (int lane = 0; lane < lanesUsed; ++lane) lanes[lane].init(prefix);
+
+    int done = 0;
+#ifdef SHA256_X86_KERNELS
+    if (lanesUsed == SHA_LANES) {
+        const uint32_t* midstates[SHA_LANES];
+        const NonceMessage* lanePointers[SHA_LANES];
+        for (int lane = 0; lane < SHA_LANES; ++lane) {
+            midstates[lane] = prefix.state();
+            lanePointers[lane] = &lanes[lane];
+        }
+        for (; count - done >= SHA_LANES; done += SHA_LANES) {
+            bool sameBlocks = true;
+            for (int lane = 0; lane < SHA_LANES; ++lane) {
+                lanes[lane].setNonce(first + done + lane);
+                sameBlocks = sameBlocks && lanes[lane].blocks == lanes[0].blocks;
+            }
+            if (sameBlocks) {
+                hashLanesAvx2(midstates, lanePointers, out + done);
+            }
+            else {
+                // the nonces crossed into one more digit and the padding spilled into another block
+                for (int lane = 0; lane < SHA_LANES; ++lane) hashOne(SCALAR_KERNEL, prefix.state(), lanes[lane], out[done + lane]);
+            }
+        }
+    }
+#endif
+    for (; done < count; ++done) {
+        lanes[0].setNonce(first + done);
+        hashOne(kernel, prefix.state(), lanes[0], out[done]);
+    }
+}
+
+void sha256Messages(const Sha256Prefix *prefixes, const long long *nonces, int count, Digest *out) {
+    if (count <= 0) return;
+    const int kernel = activeKernel().load();
+    std::vector<NonceMessage> messages(count);
+    for (int i = 0; i < count; ++i) {
+        messages[i].init(prefixes[i]);
+        messages[i].setNonce(nonces[i]);
+    }
+    std::vector<char> hashed(count, 0);
+#ifdef SHA256_X86_KERNELS
+    if (kernel == AVX2_KERNEL) {
+        // messages with the same block count fill the lanes together, in the order they come
+        std::vector<std::vector<int> > byBlocks;
+        for (int i = 0; i < count; ++i) {
+            const int blocks = messages[i].blocks;
+            if ((int)byBlocks.size() <= blocks) byBlocks.resize(blocks + 1);
+            byBlocks[blocks].push_back(i);
+            if (byBlocks[blocks].size() < SHA_LANES) continue;
+            const uint32_t* midstates[SHA_LANES];
+            const NonceMessage* lanes[SHA_LANES];
+            Digest digests[SHA_LANES];
+            for (int lane = 0; lane < SHA_LANES; ++lane) {
+                midstates[lane] = prefixes[byBlocks[blocks][lane]].state();
+                lanes[lane] = &messages[byBlocks[blocks][lane]];
+            }
+            hashLanesAvx2(midstates, lanes, digests);
+            for (int lane = 0; lane < SHA_LANES; ++lane) {
+                out[byBlocks[blocks][lane]] = digests[lane];
+                hashed[byBlocks[blocks][lane]] = 1;
+            }
+            byBlocks[blocks].clear();
+        }
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+        if (!hashed[i]) hashOne(kernel, prefixes[i].state(), messages[i], out[i]);
+    }
+}
+
+std::string digestHex(const Digest &digest) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string hex(64, '0');
+    for (int i = 0; i < 32; ++i) {
+        hex[2 * i] = HEX[digest[i] >> 4];
+        hex[2 * i + 1] = HEX[digest[i] & 15];
+    }
+    return hex;
+}
+
+bool digestFromHex(const std::string &hex, Digest &out) {
+    if (hex.size() != 64) return false;
+    for (int i = 0; i < 64; ++i) {
+        const char c = hex[i];
+        int value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else return false;
+        if (i % 2 == 0) out[i / 2] = (uint8_t)(value << 4);
+        else out[i / 2] |= (uint8_t)value;
+    }
+    return true;
+}
+
+Digest zeroBitsTarget(int bits) {
+    Digest target;
+    target.fill(0xff);
+    if (bits <= 0) return target;
+    if (bits > 256) bits = 256;
+    for (int i = 0; i < bits / 8; ++i) target[i] = 0;
+    if (bits < 256 && bits % 8 != 0) target[bits / 8] = (uint8_t)(0xff >> (bits % 8));
+    return target;
+}
+
+bool meetsTarget(const Digest &digest, const Digest &target) {
+    for (int i = 0; i < 32; ++i) {
+        if (digest[i] != target[i]) return digest[i] < target[i];
+    }
+    return true;
+}
+
+int leadingZeroBits(const Digest &digest) {
+    int bits = 0;
+    for (int i = 0; i < 32; ++i) {
+        if (digest[i] == 0) {
+            bits += 8;
+            continue;
+        }
+        for (uint8_t mask = 0x80; (digest[i] & mask) == 0; mask >>= 1) ++bits;
+        break;
+    }
+    return bits;
+}
+
+double targetProbability(const Digest &target) {
+    double probability = std::ldexp(1.0, -256);
+    for (int i = 0; i < 32; ++i) probability += std::ldexp((double)target[i], -8 * (i + 1));
+    return probability;
+}
+
+std::string sha256Kernel() {
+    switch (activeKernel().load()) {
+    case SHA_NI_KERNEL: return "sha-ni";
+    case AVX2_KERNEL:   return "avx2";
+    default:            return "scalar";
+    }
+}
+
+bool setSha256Kernel(const std::string &kernel) {
+    if (kernel == "scalar") activeKernel().store(SCALAR_KERNEL);
+    else if (kernel == "avx2" && cpuHasAvx2()) activeKernel().store(AVX2_KERNEL);
+    else if (kernel == "sha-ni" && cpuHasShaNi()) activeKernel().store(SHA_NI_KERNEL);
+    else return false;
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef JMUZINA_SHA256BATCH
+#define JMUZINA_SHA256BATCH
+
+// SHA-256 of prefix + decimal nonce for a run of consecutive nonces. The prefix is copied once
+// per lane and only the nonce digits and padding are rewritten between hashes. On x86 the lanes
+// go through SHA-NI, or 8 at a time through AVX2, when the CPU has them, otherwise through plain
+// C++. Every kernel gives the same digests as picosha2.
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+typedef std::array<uint8_t, 32> Digest;
+
+static const int SHA_LANES = 8; // nonces the AVX2 kernel hashes per pass
+
+// A message prefix with every whole 64 byte block already compressed (the midstate), hashing
+// prefix + nonce then only compresses the tail. Miners hash prevHash + id + nonce, and prevHash is
+// exactly one block, so one midstate per tip serves every nonce and every block built on that tip.
+class Sha256Prefix {
+protected:
+    uint32_t                        _state[8];
+    uint64_t                        _compressed; // bytes folded into _state
+    std::string                     _tail; // bytes after the last whole block
+
+public:
+                                    Sha256Prefix            ();
+    explicit                        Sha256Prefix            (const std::string &prefix);
+
+    // this prefix followed by more, only the new bytes are compressed
+    Sha256Prefix                    extended                (const std::string &more) const;
+
+    const uint32_t*                 state                   () const                    { return _state; };
+    uint64_t                        compressed              () const                    { return _compressed; };
+    const std::string&              tail                    () const                    { return _tail; };
+    uint64_t                        size                    () const                    { return _compressed + _tail.size(); };
+};
+
+// out[i] = sha256(prefix + std::to_string(first + i)) for i in [0, count)
+void            sha256Nonces            (const Sha256Prefix &prefix, long long first, int count, Digest *out);
+void            sha256Nonces            (const std::string &prefix, long long first, int count, Digest *out);
+// out[i] = sha256(prefixes[i] + std::to_string(nonces[i])), unrelated messages share the AVX2 lanes
+void            sha256Messages          (const Sha256Prefix *prefixes, const long long *nonces, int count, Digest *out);
+// lower case hex of a digest, the same string picosha2::hash256_hex_string gives
+std::string     digestHex               (const Digest &digest);
+// reads 64 hex digits back into a digest, false if hex is anything else
+bool            digestFromHex           (const std::string &hex, Digest &out);
+
+// Proof of work targets are 256 bit big endian thresholds, a digest solves the puzzle if it is
+// at most the target. Whole zero bits are the old "000" style (12 bits), any other threshold
+// tunes the difficulty in between.
+Digest          zeroBitsTarget          (int bits);
+bool            meetsTarget             (const Digest &digest, const Digest &target);
+int             leadingZeroBits         (const Digest &digest);
+// chance that one hash meets the target, (target + 1) / 2^256
+double          targetProbability       (const Digest &target);
+// kernel sha256Nonces uses: "sha-ni", "avx2" or "scalar"
+std::string     sha256Kernel            ();
+// picks a kernel (for tests and benchmarks), false and no change if this CPU can not run it
+bool            setSha256Kernel         (const std::string &kernel);
+
+#endif
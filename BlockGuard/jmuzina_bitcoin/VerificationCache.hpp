@@ -0,0 +1,98 @@
+#ifndef JMUZINA_VERIFICATIONCACHE
+#define JMUZINA_VERIFICATIONCACHE
+
+// Blocks whose proof of work one miner has already hashed, shared by every miner in the process.
+// Entries are keyed by the digest a block claims and remember what was hashed to get it, so a hit
+// is only an O(1) lookup and a compare. Only blocks that checked out are kept, a forged block
+// claiming a cached digest differs in its inputs and is hashed like any other.
+
+#include "Sha256Batch.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class VerificationCache {
+protected:
+    struct Inputs {
+        std::string                 prevHash;
+        std::string                 minerId;
+        long long                   nonce;
+    };
+    struct DigestHash {
+        size_t operator()(const Digest &digest) const { size_t h; std::memcpy(&h, digest.data(), sizeof(h)); return h; };
+    };
+    struct Shard {
+        std::mutex                                      lock;
+        std::unordered_map<Digest, Inputs, DigestHash>  verified;
+    };
+
+    static const int                SHARDS = 64; // miners verifying in parallel rarely wait on one another
+    static const size_t             SHARD_CAPACITY = 1 << 16; // a full shard starts over
+
+    Shard                           _shards[SHARDS];
+    std::atomic<unsigned long long> _hits;
+    std::atomic<unsigned long long> _misses;
+
+    Shard&                          shardFor                (const Digest &digest)      { return _shards[digest[31] % SHARDS]; };
+
+public:
+                                    VerificationCache       () : _hits(0), _misses(0)   {};
+                                    VerificationCache       (const VerificationCache&) = delete;
+
+    // true if this exact block was verified before, counts a hit or a miss
+    bool                            contains                (const Digest &claimed, const std::string &prevHash, const std::string &minerId, long long nonce);
+    // records a block whose digest was just checked
+    void                            insert                  (const Digest &claimed, const std::string &prevHash, const std::string &minerId, long long nonce);
+    void                            clear                   ();
+
+    unsigned long long              hits                    () const                    { return _hits.load(); };
+    unsigned long long              misses                  () const                    { return _misses.load(); };
+    // share of lookups that skipped the hash, 0 before any lookup
+    double                          hitRate                 () const;
+    void                            resetCounters           ()                          { _hits = 0; _misses = 0; };
+
+    VerificationCache&              operator=               (const VerificationCache&) = delete;
+};
+
+inline bool VerificationCache::contains(const Digest &claimed, const std::string &prevHash, const std::string &minerId, long long nonce) {
+    Shard &shard = shardFor(claimed);
+    bool found;
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto entry = shard.verified.find(claimed);
+        found = entry != shard.verified.end() && entry->second.nonce == nonce && entry->second.prevHash == prevHash && entry->second.minerId == minerId;
+    }
+    if (found) ++_hits;
+    else ++_misses;
+    return found;
+}
+
+inline void VerificationCache::insert(const Digest &claimed, const std::string &prevHash, const std::string &minerId, long long nonce) {
+    Shard &shard = shardFor(claimed);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (shard.verified.size() >= SHARD_CAPACITY) shard.verified.clear();
+    shard.verified[claimed] = Inputs{prevHash, minerId, nonce};
+}
+
+inline void VerificationCache::clear() {
+    for (int i = 0; i < SHARDS; ++i) {
+        std::lock_guard<std::mutex> guard(_shards[i].lock);
+        _shards[i].verified.clear();
+    }
+    resetCounters();
+}
+
+inline double VerificationCache::hitRate() const {
+    const unsigned long long lookups = hits() + misses();
+    return (lookups == 0 ? 0.0 : (double)hits() / lookups);
+}
+
+// the cache every BitcoinMiner verifies through
+inline VerificationCache& verificationCache() {
+    static VerificationCache cache;
+    return cache;
+}
+
+#endif
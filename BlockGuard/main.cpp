@@ -31,6 +31,8 @@
 #include "./bCoin/bCoin_Peer.hpp"
 #include "./bCoin/bCoin_Committee.hpp"
 #include "./bCoin/DS_bCoin_Peer.hpp"
+#include "jmuzina_bitcoin/BitcoinMessage.hpp"
+#include "jmuzina_bitcoin/BitcoinMiner.hpp"
 // Smart Shards
 #include "Experiments/SmartShards_Experiments.h"
 // UTIL
@@ -50,17 +52,31 @@ int shuffleByzantineInterval = 0;
 void buildInitialChain(std::vector<std::string>);
 std::set<std::string> getPeersForConsensus(int);
 
-void Example(std::ofstream& logFile);
+void Example(std::ofstream& logFile, bool sampledMining, bool pools);
 void syncBFT(const char** argv);
-void bitcoin(std::ofstream&, int);
+void bitcoin(std::ofstream&, int avgDelay, int threads);
 void DS_bitcoin(const char** argv);
 void run_DS_PBFT(const char** argv);
+void PBFT(const std::string&, int window, int batchSize, int batchWait, int threads);
 void markPBFT(const std::string&);
 void smartShard(const std::string&);
 std::vector<double> partition(const std::string&, int avgdelay, int rounds);
 
 int main(int argc, const char* argv[]) {
-	srand((float)time(NULL));
+	// --seed N may appear anywhere, it is taken out before the positional arguments are read
+	std::vector<const char*> args;
+	for (int i = 0; i < argc; i++) {
+		if (std::string(argv[i]) == "--seed" && i + 1 < argc) {
+			setSimulationSeed(std::stoull(argv[++i]));
+		}
+		else {
+			args.push_back(argv[i]);
+		}
+	}
+	argc = (int)args.size();
+	argv = args.data();
+	std::cerr << "seed: " << simulationSeed() << std::endl;
+	srand((unsigned)simulationSeed());
 	if (argc < 3) {
 		std::cerr << "Error: need algorithm and output path" << std::endl;
 		return 0;
@@ -71,13 +87,22 @@ int main(int argc, const char* argv[]) {
 	std::string filePath = argv[2];
 
 	if (algorithm == "example") {
+		//	Program arguments: example outputPath [sampled] [pools] [verify threads]
+		bool sampled = false, pools = false;
+		for (int i = 3; i < argc; i++) {
+			sampled = sampled || std::string(argv[i]) == "sampled";
+			pools = pools || std::string(argv[i]) == "pools";
+			if (std::string(argv[i]) == "verify" && i + 1 < argc) {
+				BitcoinMiner::setVerifyThreads(std::stoi(argv[++i]));
+			}
+		}
 		std::ofstream out;
 		std::string file = filePath + "/example.log";
 		out.open(file);
 		if (out.fail()) {
 			std::cerr << "Error: could not open file " << file << std::endl;
 		}
-		Example(out);
+		Example(out, sampled, pools);
 	}
 	else if (algorithm == "syncBFT") {
 		//	Program arguments: syncBFT fileName 2 1 1 128 100 0.3 1
@@ -88,7 +113,9 @@ int main(int argc, const char* argv[]) {
 		}
 	}
 	else if (algorithm == "pbft_s") {
-		PBFT_refCom(filePath);
+		//	Program arguments: pbft_s outputPath [threads]
+		int threads = argc > 3 ? std::stoi(argv[3]) : 1;
+		PBFT_refCom(filePath, threads);
 	}
 	else if (algorithm == "pow_s") {
 		POW_refCom(filePath);
@@ -97,8 +124,10 @@ int main(int argc, const char* argv[]) {
 		SBFT_refCom(filePath);
 	}
 	else if (algorithm == "bitcoin") {
+		//	Program arguments: bitcoin outputPath [threads]
 		std::ofstream out;
-		bitcoin(out, 1);
+		int threads = argc > 3 ? std::stoi(argv[3]) : 1;
+		bitcoin(out, 1, threads);
 	}
 	else if (algorithm == "DS_bitcoin") {
 		//	Program arguments: DS_bitcoin asdf 1 1 1 64 100 0.7 1
@@ -116,6 +145,14 @@ int main(int argc, const char* argv[]) {
 			run_DS_PBFT(argv);
 		}
 	}
+	else if (algorithm == "pbft") {
+		//	Program arguments: pbft outputPath [window] [batch size] [batch wait] [threads]
+		int window = argc > 3 ? std::stoi(argv[3]) : 1;
+		int batchSize = argc > 4 ? std::stoi(argv[4]) : 1;
+		int batchWait = argc > 5 ? std::stoi(argv[5]) : 0;
+		int threads = argc > 6 ? std::stoi(argv[6]) : 1;
+		PBFT(filePath, window, batchSize, batchWait, threads);
+	}
 	else if (algorithm == "markpbft") {
 		markPBFT(filePath);
 	}
@@ -153,14 +190,12 @@ int main(int argc, const char* argv[]) {
 	return 0;
 }
 
-#include "jmuzina_bitcoin/BitcoinMessage.hpp"
-#include "jmuzina_bitcoin/BitcoinMiner.hpp"
-
 int roundsNeeded(ByzantineNetwork<BitcoinMessage, BitcoinMiner> &system) {
 	int miner = 0;
 	int completed = 0;
 	int rounds = 0;
 	system[0]->preformComputation(); // mine genesis block
+	system[0]->transmit();
 	while (completed != system.size()) {
 		if ((system[miner]->getCurChain()->getChainSize() == 1) && miner != 0) system[miner]->readBlock();
 		else if (!system[miner]->getExperimentOver()) {
@@ -168,17 +203,26 @@ int roundsNeeded(ByzantineNetwork<BitcoinMessage, BitcoinMiner> &system) {
 			++rounds;
 			if (system[miner]->getExperimentOver()) ++completed;
 		}
+		else system[miner]->readBlock(); // finished miners still answer requests for their blocks
+		system[miner]->transmit(); // a step only queues its messages, they go out here
 		if (miner == system.size() - 1) miner = 0;
 		else ++miner;
 	}
 	return rounds;
 }
 
-void Example(std::ofstream& logFile) {
+void Example(std::ofstream& logFile, bool sampledMining, bool pools) {
 	const float TRIALS = 20.0;
 	const int MINERS = 100;
 	const float BLOCKS = 100;
 	const bool PRINT_INCONSISTENCIES = true;
+	// Nonces a miner tries each round. pools gives miner i (i % POOL_SIZES + 1) times this so hash power
+	// is uneven, otherwise every miner tries one
+	const long long HASH_RATE = 16;
+	const int POOL_SIZES = 4;
+	// sampledMining draws when each block is found instead of hashing for it, the blocks then do not meet the
+	// target unless REAL_HASHING also hashes a valid nonce for each one
+	const bool REAL_HASHING = false;
 
 	for (int delay = 2; delay <= 25; ++delay) {
 		float totalThroughput = 0.0;
@@ -186,7 +230,9 @@ void Example(std::ofstream& logFile) {
 		// Maximum allowed fork depth - forks may appear near end of chain, increasing in frequency and depth with delay.
 		const int maxForkPos = (BLOCKS * 0.85) - (3 * (delay - 1)); 
 		int numForks = 0, trialForksSum = 0;
+		double relayBytes = 0.0, blockBytes = 0.0; // wire bytes every miner sent, over all trials
 		std::cout << "\n---------------Running " << TRIALS << " trials with avg delay = " << delay << "---------------\n";
+		verificationCache().resetCounters();
 		for (int trial = 1; trial <= TRIALS; ++trial) {
 			ByzantineNetwork<BitcoinMessage, BitcoinMiner> system;
 			system.setLog(logFile);
@@ -195,6 +241,11 @@ void Example(std::ofstream& logFile) {
 			system.setAvgDelay(delay);
 			system.setMaxDelay(delay + 1);
 			system.initNetwork(MINERS);
+			for (int i = 0; i < MINERS; ++i) {
+				system[i]->setHashRate(pools ? HASH_RATE * (i % POOL_SIZES + 1) : 1);
+				system[i]->setSampledMining(sampledMining);
+				system[i]->setRealHashing(REAL_HASHING);
+			}
 
 			int trialFork = BLOCKS;
 			
@@ -204,6 +255,10 @@ void Example(std::ofstream& logFile) {
 			float throughput = BLOCKS / roundsToComplete;
 			std::cout << "Trial " << trial << ":\t" << throughput << " blocks per round. (" << roundsToComplete << " rounds)\n";
 			totalThroughput += throughput;
+			for (int i = 0; i < MINERS; ++i) {
+				relayBytes += system[i]->bytesSent();
+				blockBytes += system[i]->bytesSent(BLOCK);
+			}
 
 			bool match = true;
 
@@ -253,28 +308,29 @@ void Example(std::ofstream& logFile) {
 		float averageThroughput = totalThroughput / TRIALS;
 		float averageLatency = totalLatency / TRIALS;
 		std::cout << "\nAvg Delay:\t" << delay << "\nAverage throughput:\t"  << averageThroughput << " blocks per round.\nAverage latency:\t" << averageLatency << "rounds.\n";
+		std::cout << "Relay traffic:\t" << relayBytes / (TRIALS * MINERS) << " bytes sent per miner, " << 100 * blockBytes / relayBytes << "% of it blocks.\n";
+		std::cout << "Verification cache:\t" << verificationCache().hits() << " hits, " << verificationCache().misses() << " hashed (" << 100 * verificationCache().hitRate() << "% skipped).\n";
 		logFile << delay << "\t" <<averageThroughput << "\t" << delay << "\t" << averageLatency << "\n";
 	}
 }
 
-void bitcoin(std::ofstream& out, int avgDelay) {
+void bitcoin(std::ofstream& out, int avgDelay, int threads) {
 	ByzantineNetwork<bCoinMessage, bCoin_Peer> n;
 	n.setToPoisson();
 	n.setAvgDelay(avgDelay);
 	n.setLog(std::cout);
 	n.initNetwork(10);
+	// bCoin peers read their neighbors' chains while stepping, so the network keeps them on one thread
+	n.setThreads(threads);
 
 	//mining delays at the beginning
 	for (int i = 0; i < n.size(); i++) {
-		n[i]->setMineNextAt(bCoin_Peer::distribution(bCoin_Peer::generator));
+		n[i]->setMineNextAt(n[i]->miningDelay());
 	}
 
-	for (int i = 1; i < 100; i++) {
-		std::cerr << "Iteration " << i << std::endl;
-		n.receive();
-		n.preformComputation();
-		n.transmit();
-	}
+	// miners sit idle between blocks, run skips those rounds
+	int stepped = n.run(99);
+	std::cerr << "Stepped " << stepped << " of 99 rounds" << std::endl;
 	int maxChain = 0;
 	for (int i = 0; i < n.size(); i++) {
 		if (n[i]->getBlockchain()->getChainSize() > maxChain)
@@ -1036,7 +1092,6 @@ void run_DS_PBFT(const char** argv) {
 
 void buildInitialChain(std::vector<std::string> peerIds) {
 	std::cerr << "Building initial chain" << std::endl;
-	srand((time(nullptr)));
 	Blockchain* preBuiltChain = new Blockchain(true);
 	int index = 1;                  //blockchain index starts from 1;
 	int blockCount = 1;
@@ -1096,6 +1151,78 @@ void smartShard(const std::string& filePath) {
 	out.close();
 }
 
+// plain PBFT with window pre-prepares in flight at once, each carrying up to batchSize requests
+// that waited at most batchWait rounds at the primary, one request a round for each delay
+void PBFT(const std::string& filePath, int window, int batchSize, int batchWait, int threads) {
+	const int PEERS = 16;
+	const int ROUNDS = 1000;
+	const double FAULT = 0.3;
+
+	std::ofstream log;
+	log.open(filePath + "/pbft.log");
+	std::string setting = "_W" + std::to_string(window) + "_B" + std::to_string(batchSize) + "_T" + std::to_string(batchWait);
+	std::ofstream csv;
+	std::string file = filePath + "/PBFTLatencyVsDelay" + setting + ".csv";
+	csv.open(file);
+	if (csv.fail()) {
+		std::cerr << "Error: could not open file " << file << std::endl;
+	}
+	csv << "delay,window,batch size,batch wait,submitted,committed,throughput,average latency" << std::endl;
+	std::ofstream batches;
+	file = filePath + "/PBFTBatchSizes" + setting + ".csv";
+	batches.open(file);
+	if (batches.fail()) {
+		std::cerr << "Error: could not open file " << file << std::endl;
+	}
+	batches << "delay,batch size,pre-prepares sent" << std::endl;
+
+	for (int delay = 1; delay <= 5; ++delay) {
+		Network<PBFT_Message, PBFT_Peer> system;
+		system.setLog(log);
+		system.setToRandom();
+		system.setMaxDelay(delay);
+		system.initNetwork(PEERS);
+		system.setThreads(threads);
+		for (int i = 0; i < PEERS; ++i) {
+			system[i]->setFaultTolerance(FAULT);
+			system[i]->setWindow(window);
+			system[i]->setBatching(batchSize, batchWait);
+			system[i]->init();
+		}
+
+		for (int round = 0; round < ROUNDS; ++round) {
+			system.makeRequest(round % PEERS);
+			system.receive();
+			system.preformComputation();
+			system.transmit();
+		}
+
+		// every peer commits the same ledger, latency is from submission to commit
+		std::vector<PBFT_Message> ledger = system[0]->getLedger();
+		double latency = 0.0;
+		for (auto entry = ledger.begin(); entry != ledger.end(); ++entry) {
+			latency += entry->commit_round - entry->submission_round;
+		}
+		double averageLatency = ledger.empty() ? 0.0 : latency / ledger.size();
+		std::cout << "delay " << delay << ":	" << ledger.size() << " of " << ROUNDS << " requests committed, average latency " << averageLatency << " rounds" << std::endl;
+		csv << delay << "," << window << "," << batchSize << "," << batchWait << "," << ROUNDS << "," << ledger.size() << "," << (double)ledger.size() / ROUNDS << "," << averageLatency << std::endl;
+
+		// pre-prepares by the number of requests they carried, from whichever peers were primary
+		std::map<int, int> sizes;
+		for (int i = 0; i < PEERS; ++i) {
+			for (auto size = system[i]->batchSizes().begin(); size != system[i]->batchSizes().end(); ++size) {
+				sizes[size->first] += size->second;
+			}
+		}
+		for (auto size = sizes.begin(); size != sizes.end(); ++size) {
+			batches << delay << "," << size->first << "," << size->second << std::endl;
+		}
+	}
+	batches.close();
+	csv.close();
+	log.close();
+}
+
 void markPBFT(const std::string& filePath) {
 	std::cout << "markPBFT" << std::endl;
 
@@ -1207,7 +1334,7 @@ void markPBFT(const std::string& filePath) {
 							// Following is used for logging
 
 							// Get Ledgers
-							std::map<std::string, int> ledger;
+							std::map<uint32_t, int> ledger;
 
 							for (int i = 0; i < networkSize; ++i)
 								ledger.insert(system[i]->ledger().begin(), system[i]->ledger().end());
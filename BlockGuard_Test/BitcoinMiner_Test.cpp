@@ -0,0 +1,635 @@
+//
+//  BitcoinMiner_Test.cpp
+//  BlockGuard
+//
+//  Tests for the proof of work miner in jmuzina_bitcoin.
+//
+
+#include "BitcoinMiner_Test.hpp"
+
+void RunBitcoinMinerTest(std::string filepath){
+    std::ofstream log;
+    log.open(filepath + "/BitcoinMiner.log");
+    if (log.fail() ){
+        std::cerr << "Error: could not open file at: "<< filepath << std::endl;
+    }
+    testShaKernels(log);
+    testHashRate(log);
+    testMidstate(log);
+    testDifficultyTarget(log);
+    testSampledMining(log);
+    testBlockStore(log);
+    testForkPoint(log);
+    testVerificationCache(log);
+    testBatchVerification(log);
+    testHeadersFirstRelay(log);
+}
+
+void testShaKernels(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testShaKernels"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    const std::string defaultKernel = sha256Kernel();
+    log<< "default kernel: "<< defaultKernel<< std::endl;
+
+    // prefixes around the block boundaries and nonce runs that gain a digit part way through
+    std::vector<std::string> prefixes = {"", "Peer_3", std::string(64, 'a') + "Peer_12", std::string(45, 'b'), std::string(119, 'c')};
+    std::vector<long long> firsts = {0, 5, 99990, -12, 9223372036854775000LL};
+    std::vector<std::string> kernels = {"scalar", "avx2", "sha-ni"};
+    for(auto kernel = kernels.begin(); kernel != kernels.end(); kernel++){
+        if(!setSha256Kernel(*kernel)){
+            log<< *kernel<< " not supported, skipped"<< std::endl;
+            continue;
+        }
+        assert(sha256Kernel()                           == *kernel);
+        for(auto prefix = prefixes.begin(); prefix != prefixes.end(); prefix++){
+            for(auto first = firsts.begin(); first != firsts.end(); first++){
+                std::vector<Digest> batch(27);
+                sha256Nonces(*prefix, *first, (int)batch.size(), batch.data());
+                for(int i = 0; i < batch.size(); i++){
+                    std::string expected;
+                    picosha2::hash256_hex_string(*prefix + std::to_string(*first + i), expected);
+                    assert(digestHex(batch[i])          == expected);
+                }
+            }
+        }
+    }
+    assert(!setSha256Kernel("md5"));
+    assert(setSha256Kernel(defaultKernel));
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testShaKernels Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testHashRate(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testHashRate"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    // two miners with the same id see the same puzzles, one tries a nonce per step and the other 16
+    BitcoinMiner single("miner");
+    BitcoinMiner batched("miner");
+    batched.setHashRate(16);
+    assert(single.getHashRate()                         == 1);
+    assert(batched.getHashRate()                        == 16);
+
+    const int BLOCKS = 4;
+    int singleSteps = 0;
+    while(single.getCurChain()->getChainSize() < BLOCKS){
+        single.preformComputation();
+        singleSteps++;
+    }
+    int batchedSteps = 0;
+    while(batched.getCurChain()->getChainSize() < BLOCKS){
+        batched.preformComputation();
+        batchedSteps++;
+    }
+    log<< "steps: "<< singleSteps<< " one at a time, "<< batchedSteps<< " in batches of 16"<< std::endl;
+    assert(batchedSteps                                 < singleSteps);
+    for(int i = 0; i < BLOCKS; i++){
+        assert(single.getCurChain()->getBlockAt(i).getHash()         == batched.getCurChain()->getBlockAt(i).getHash());
+        assert(single.getCurChain()->getBlockAt(i).getPreviousHash() == batched.getCurChain()->getBlockAt(i).getPreviousHash());
+    }
+    // the winning nonce is the one recorded in the block
+    const splitHash tip(single.getCurChain()->getBlockAt(BLOCKS - 1).getHash());
+    const std::string prevHash = splitHash(single.getCurChain()->getBlockAt(BLOCKS - 2).getHash()).getHash();
+    std::string expected;
+    picosha2::hash256_hex_string(prevHash + "miner" + std::to_string(tip.getNonce()), expected);
+    assert(tip.getHash()                                == expected);
+    assert(expected.substr(0, 3)                        == "000");
+
+    // a budget bigger than one puzzle keeps mining on the new tip in the same step, and the blocks
+    // are the ones the slow miner finds
+    BitcoinMiner fast("miner");
+    fast.setHashRate(1 << 16);
+    fast.preformComputation(); // genesis
+    fast.preformComputation();
+    log<< "blocks mined in one step of 65536 hashes: "<< fast.getCurChain()->getChainSize() - 1<< std::endl;
+    assert(fast.getCurChain()->getChainSize()           > BLOCKS);
+    for(int i = 0; i < BLOCKS; i++){
+        assert(single.getCurChain()->getBlockAt(i).getHash()         == fast.getCurChain()->getBlockAt(i).getHash());
+    }
+    // the budget stops at the end of the experiment
+    fast.setHashRate(1 << 22);
+    fast.preformComputation();
+    assert(fast.getCurChain()->getChainSize()           == 100);
+    assert(fast.getExperimentOver());
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testHashRate Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testMidstate(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testMidstate"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // whole blocks are folded into the midstate and only the tail is kept
+    const std::string prevHash(64, 'f');
+    Sha256Prefix tip(prevHash);
+    assert(tip.compressed()                             == 64);
+    assert(tip.tail().empty());
+    Sha256Prefix mining = tip.extended("Peer_7");
+    assert(mining.compressed()                          == 64);
+    assert(mining.tail()                                == "Peer_7");
+    assert(mining.size()                                == 70);
+    Sha256Prefix longer = mining.extended(std::string(130, 'x'));
+    assert(longer.compressed()                          == 192);
+    assert(longer.size()                                == 200);
+
+    const std::vector<std::string> kernels = {"scalar", "avx2", "sha-ni"};
+    const std::string defaultKernel = sha256Kernel();
+    for(auto kernel = kernels.begin(); kernel != kernels.end(); kernel++){
+        if(!setSha256Kernel(*kernel)){
+            continue;
+        }
+        std::vector<Digest> fromMidstate(20);
+        std::vector<Digest> fromString(20);
+        sha256Nonces(mining, 95, (int)fromMidstate.size(), fromMidstate.data());
+        sha256Nonces(prevHash + "Peer_7", 95, (int)fromString.size(), fromString.data());
+        assert(fromMidstate                             == fromString);
+        sha256Nonces(longer, 0, (int)fromMidstate.size(), fromMidstate.data());
+        sha256Nonces(prevHash + "Peer_7" + std::string(130, 'x'), 0, (int)fromString.size(), fromString.data());
+        assert(fromMidstate                             == fromString);
+    }
+    assert(setSha256Kernel(defaultKernel));
+
+    ///////////////////////////////////////
+    // the miner's cached prefix follows its tip, and verification hashes agree with picosha2
+    BitcoinMiner miner("miner");
+    miner.setHashRate(32);
+    while(miner.getCurChain()->getChainSize() < 3){
+        miner.preformComputation();
+    }
+    const std::string tipHash = splitHash(miner.getCurChain()->getBlockAt(2).getHash()).getHash();
+    std::string expected;
+    picosha2::hash256_hex_string(tipHash + "miner" + std::to_string(41), expected);
+    assert(miner.getSHA(41)                             == expected);
+
+    const splitHash block2(miner.getCurChain()->getBlockAt(2).getHash());
+    const std::string block1 = splitHash(miner.getCurChain()->getBlockAt(1).getHash()).getHash();
+    assert(miner.blockSHA(block1, "miner", block2.getNonce()) == block2.getHash());
+    picosha2::hash256_hex_string(block1 + "other" + std::to_string(7), expected);
+    assert(miner.blockSHA(block1, "other", 7)           == expected);
+
+    // switching to a shorter chain moves the prefix back to that chain's tip
+    Blockchain shorter(true);
+    miner.setCurChain(shorter);
+    picosha2::hash256_hex_string("miner" + std::to_string(3), expected);
+    assert(miner.getSHA(3)                              == expected);
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testMidstate Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testDifficultyTarget(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testDifficultyTarget"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // targets and comparisons
+    Digest twelve = zeroBitsTarget(12);
+    assert(twelve[0]                                    == 0x00);
+    assert(twelve[1]                                    == 0x0f);
+    assert(twelve[2]                                    == 0xff);
+    assert(zeroBitsTarget(0)[0]                         == 0xff);
+    assert(zeroBitsTarget(256)[31]                      == 0x00);
+    assert(leadingZeroBits(twelve)                      == 12);
+    assert(leadingZeroBits(zeroBitsTarget(256))         == 256);
+
+    Digest digest;
+    assert(digestFromHex("000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", digest));
+    assert(meetsTarget(digest, twelve));                // equal to the target
+    assert(digestFromHex("0010000000000000000000000000000000000000000000000000000000000000", digest));
+    assert(!meetsTarget(digest, twelve));               // one past it
+    assert(leadingZeroBits(digest)                      == 11);
+    assert(digestFromHex("000a3c0000000000000000000000000000000000000000000000000000000000", digest));
+    assert(meetsTarget(digest, twelve));
+    assert(digestHex(digest)                            == "000a3c0000000000000000000000000000000000000000000000000000000000");
+    assert(!digestFromHex("000a3c", digest));
+    assert(!digestFromHex(std::string(63, '0') + "g", digest));
+
+    ///////////////////////////////////////
+    // the default is the old "000" prefix
+    BitcoinMiner miner("miner");
+    assert(miner.getTarget()                            == twelve);
+    miner.setHashRate(64);
+    while(miner.getCurChain()->getChainSize() < 4){
+        miner.preformComputation();
+    }
+    for(int i = 2; i < 4; i++){
+        assert(splitHash(miner.getCurChain()->getBlockAt(i).getHash()).getHash().substr(0, 3) == "000");
+    }
+
+    ///////////////////////////////////////
+    // easier whole bit targets and a threshold between two bit counts
+    BitcoinMiner easy("easy");
+    easy.setDifficulty(6);
+    easy.setHashRate(8);
+    while(easy.getCurChain()->getChainSize() < 8){
+        easy.preformComputation();
+    }
+    Digest threshold = zeroBitsTarget(6);
+    threshold[0] = 0x02; // between 6 and 7 zero bits
+    easy.setTarget(threshold);
+    assert(easy.getTarget()                             == threshold);
+    while(easy.getCurChain()->getChainSize() < 14){
+        easy.preformComputation();
+    }
+    for(int i = 2; i < 14; i++){
+        Digest mined;
+        assert(digestFromHex(splitHash(easy.getCurChain()->getBlockAt(i).getHash()).getHash(), mined));
+        assert(leadingZeroBits(mined)                   >= 6);
+        if(i >= 8){
+            assert(meetsTarget(mined, threshold));
+        }
+    }
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testDifficultyTarget Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testSampledMining(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testSampledMining"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // odds of one hash meeting a target
+    assert(std::abs(targetProbability(zeroBitsTarget(12)) * 4096 - 1) < 1e-9);
+    assert(std::abs(targetProbability(zeroBitsTarget(20)) * 1048576 - 1) < 1e-9);
+    assert(targetProbability(zeroBitsTarget(0))         > 1 - 1e-9);
+
+    ///////////////////////////////////////
+    // 98 blocks at 64 hashes a round and 1 in 4096 odds take about 6272 rounds
+    BitcoinMiner sampled("miner");
+    sampled.setSampledMining(true);
+    sampled.setHashRate(64);
+    assert(sampled.getSampledMining());
+    assert(!sampled.getRealHashing());
+    int steps = 0;
+    while(!sampled.getExperimentOver()){
+        sampled.preformComputation();
+        steps++;
+    }
+    log<< "sampled rounds for 100 blocks: "<< steps<< std::endl;
+    assert(sampled.getCurChain()->getChainSize()        == 100);
+    assert(steps                                        > 3000);
+    assert(steps                                        < 12000);
+
+    // a miner that catches up verifies the sampled blocks like mined ones
+    BitcoinMiner follower("follower");
+    follower.preformComputation(); // genesis
+    follower.catchUpAndVerify(sampled.getCurChain());
+    assert(follower.getCurChain()->getChainSize()       == 100);
+    for(int i = 0; i < 100; i++){
+        assert(follower.getCurChain()->getBlockAt(i).getHash() == sampled.getCurChain()->getBlockAt(i).getHash());
+    }
+
+    ///////////////////////////////////////
+    // the miner says which round its next block is in and finds nothing before it
+    BitcoinMiner sleeper("sleeper");
+    sleeper.setSampledMining(true);
+    sleeper.preformComputation(); // genesis
+    sleeper.preformComputation();
+    for(int block = 0; block < 3; block++){
+        const int size = sleeper.getCurChain()->getChainSize();
+        const int wake = sleeper.nextWakeup();
+        assert(wake                                     >= sleeper.getClock());
+        while(sleeper.getClock() + 1 < wake){
+            sleeper.preformComputation();
+            assert(sleeper.getCurChain()->getChainSize() == size);
+        }
+        if(sleeper.getClock() < wake){
+            sleeper.preformComputation();
+        }
+        assert(sleeper.getCurChain()->getChainSize()    == size + 1); // one hash a round, at most one block
+    }
+
+    ///////////////////////////////////////
+    // real hashing keeps the sampled timing but the blocks meet the target
+    BitcoinMiner checked("checked");
+    checked.setSampledMining(true);
+    checked.setRealHashing(true);
+    checked.setHashRate(256);
+    while(checked.getCurChain()->getChainSize() < 8){
+        checked.preformComputation();
+    }
+    for(int i = 2; i < 8; i++){
+        const splitHash block(checked.getCurChain()->getBlockAt(i).getHash());
+        const std::string prevHash = splitHash(checked.getCurChain()->getBlockAt(i - 1).getHash()).getHash();
+        Digest mined;
+        assert(digestFromHex(block.getHash(), mined));
+        assert(meetsTarget(mined, checked.getTarget()));
+        assert(checked.hashMatches(block.getHash(), prevHash, "checked", block.getNonce()));
+    }
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testSampledMining Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testBlockStore(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testBlockStore"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // the same block on the same tip is one node, copies share the tip
+    Blockchain a(true);
+    Blockchain b(true);
+    assert(a.getTip()                                   == b.getTip());
+    a.createBlock(1, "genesisHash", "h1", {"x"});
+    b.createBlock(1, "genesisHash", "h1", {"x"});
+    assert(a.getTip()                                   == b.getTip());
+    b.createBlock(2, "h1", "h2", {"y"});
+    assert(a.getChainSize()                             == 2);
+    assert(b.getChainSize()                             == 3);
+    assert(b.getTip()->parent()                         == a.getTip().get());
+    Blockchain c(a);
+    assert(c.getTip()                                   == a.getTip());
+    c.createBlock(2, "h1", "h2c", {"z"});
+    assert(c.getTip()                                   != b.getTip());
+    assert(a.getChainSize()                             == 2);
+    assert(c.getBlockAt(1).getHash()                    == "h1");
+    // the same hash with other contents is kept apart
+    Blockchain d(true);
+    d.createBlock(1, "genesisHash", "h1", {"w"});
+    assert(d.getTip()                                   != a.getTip());
+    assert(*d.getBlockAt(1).getPublishers().begin()     == "w");
+    Blockchain empty(false);
+    assert(empty.getChainSize()                         == 0);
+
+    ///////////////////////////////////////
+    // long chains: blocks by height through the skip pointers, copies are O(1) and freeing does not recurse
+    const int LENGTH = 100000;
+    Blockchain *longChain = new Blockchain(true);
+    for(int i = 1; i < LENGTH; i++){
+        longChain->createBlock(i, std::to_string(i - 1), std::to_string(i), {"long"});
+    }
+    assert(longChain->getChainSize()                    == LENGTH);
+    for(int i = 0; i < LENGTH; i += 997){
+        assert(longChain->getBlockAt(i).getIndex()      == i);
+    }
+    assert(longChain->getBlockAt(LENGTH - 1).getHash()  == std::to_string(LENGTH - 1));
+    assert(longChain->getBlockAt(0).getHash()           == "genesisHash");
+    assert(longChain->getTip()->ancestor(LENGTH)        == nullptr);
+    Blockchain copied = *longChain;
+    assert(copied.getTip()                              == longChain->getTip());
+    delete longChain;
+    assert(copied.getBlockAt(LENGTH / 2).getIndex()     == LENGTH / 2);
+    copied = a;
+
+    // blocks no chain holds are dropped as the store grows, dead chains do not pile up
+    for(int round = 0; round < 6; round++){
+        Blockchain dead(true);
+        for(int i = 1; i < LENGTH / 2; i++){
+            dead.createBlock(i, "", std::to_string(round) + "_" + std::to_string(i), {"dead"});
+        }
+    }
+    log<< "blocks in the store after 300000 dead blocks: "<< blockStore().size()<< std::endl;
+    assert(blockStore().size()                          < 3 * LENGTH);
+
+    ///////////////////////////////////////
+    // a miner that catches up ends on the very blocks it verified
+    BitcoinMiner leader("leader");
+    leader.setHashRate(1 << 14);
+    while(leader.getCurChain()->getChainSize() < 6){
+        leader.preformComputation();
+    }
+    BitcoinMiner follower("follower");
+    follower.preformComputation(); // genesis
+    follower.catchUpAndVerify(leader.getCurChain());
+    assert(follower.getCurChain()->getTip()             == leader.getCurChain()->getTip());
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testBlockStore Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testForkPoint(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testForkPoint"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // forks at every depth of a 5000 block trunk, branches of different lengths
+    const int TRUNK = 5000;
+    Blockchain trunk(true);
+    for(int i = 1; i < TRUNK; i++){
+        trunk.createBlock(i, std::to_string(i - 1), "t" + std::to_string(i), {"trunk"});
+    }
+    const std::vector<int> forkAt = {0, 1, 2, 63, 64, 65, 1000, 2047, 4096, TRUNK - 2, TRUNK - 1};
+    for(int f = 0; f < forkAt.size(); f++){
+        Blockchain branch(trunk);
+        branch.truncate(forkAt[f] + 1);
+        assert(branch.getChainSize()                    == forkAt[f] + 1);
+        assert(branch.getTip().get()                    == trunk.getTip()->ancestor(forkAt[f]));
+        for(int i = 0; i < 7 * (f + 1); i++){
+            branch.createBlock(branch.getChainSize(), "", "b" + std::to_string(i), {"branch"});
+        }
+        const BlockNode *common = BlockNode::lastCommonAncestor(branch.getTip().get(), trunk.getTip().get());
+        assert(common                                   != nullptr);
+        assert(common->height()                         == forkAt[f]);
+        assert(common                                   == BlockNode::lastCommonAncestor(trunk.getTip().get(), branch.getTip().get()));
+    }
+    // a chain and its own prefix, and chains that share nothing
+    Blockchain prefix(trunk);
+    prefix.truncate(1234);
+    assert(BlockNode::lastCommonAncestor(prefix.getTip().get(), trunk.getTip().get()) == prefix.getTip().get());
+    assert(BlockNode::lastCommonAncestor(trunk.getTip().get(), trunk.getTip().get())  == trunk.getTip().get());
+    Blockchain other(false);
+    other.createBlock(0, "-1_-1", "otherGenesis", {});
+    other.createBlock(1, "otherGenesis", "o1", {"other"});
+    assert(BlockNode::lastCommonAncestor(other.getTip().get(), trunk.getTip().get())  == nullptr);
+    prefix.truncate(0);
+    assert(prefix.getChainSize()                        == 0);
+
+    ///////////////////////////////////////
+    // a miner that lost a fork race drops its own block and takes the longer chain's
+    BitcoinMiner leader("leader");
+    leader.setHashRate(1 << 14);
+    while(leader.getCurChain()->getChainSize() < 6){
+        leader.preformComputation();
+    }
+    BitcoinMiner loser("loser");
+    loser.setHashRate(1 << 14);
+    Blockchain shared(*leader.getCurChain());
+    shared.truncate(4);
+    loser.setCurChain(shared);
+    loser.preformComputation();
+    assert(loser.getCurChain()->getChainSize()          >= 5);
+    assert(*loser.getCurChain()->getBlockAt(4).getPublishers().begin() == "loser");
+    while(leader.getCurChain()->getChainSize() <= loser.getCurChain()->getChainSize()){
+        leader.preformComputation();
+    }
+    loser.catchUpAndVerify(leader.getCurChain());
+    assert(loser.getCurChain()->getTip()                == leader.getCurChain()->getTip());
+    assert(loser.getBeaten());
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testForkPoint Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testVerificationCache(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testVerificationCache"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    verificationCache().clear();
+    assert(verificationCache().hitRate()                == 0);
+
+    BitcoinMiner source("source");
+    source.setHashRate(1 << 14);
+    while(source.getCurChain()->getChainSize() < 12){
+        source.preformComputation();
+    }
+    const int MINED = source.getCurChain()->getChainSize() - 2; // blocks past the genesis block
+
+    // the first miner to catch up hashes every block, the rest only look them up
+    BitcoinMiner first("first");
+    first.preformComputation();
+    first.catchUpAndVerify(source.getCurChain());
+    assert(verificationCache().misses()                 == MINED);
+    assert(verificationCache().hits()                   == 0);
+    for(int i = 0; i < 5; i++){
+        BitcoinMiner later("later" + std::to_string(i));
+        later.preformComputation();
+        later.catchUpAndVerify(source.getCurChain());
+        assert(later.getCurChain()->getTip()            == source.getCurChain()->getTip());
+    }
+    log<< "hits: "<< verificationCache().hits()<< " misses: "<< verificationCache().misses()<< std::endl;
+    assert(verificationCache().misses()                 == MINED);
+    assert(verificationCache().hits()                   == 5 * MINED);
+    assert(std::abs(verificationCache().hitRate() - 5.0 / 6) < 1e-9);
+
+    // a block that claims a cached digest with other inputs is hashed and rejected
+    const splitHash block(source.getCurChain()->getBlockAt(3).getHash());
+    const std::string prevHash = splitHash(source.getCurChain()->getBlockAt(2).getHash()).getHash();
+    assert(first.hashMatches(block.getHash(), prevHash, "source", block.getNonce()));
+    assert(!first.hashMatches(block.getHash(), prevHash, "source", block.getNonce() + 1));
+    assert(!first.hashMatches(block.getHash(), prevHash, "forger", block.getNonce()));
+    assert(!first.hashMatches(block.getHash(), block.getHash(), "source", block.getNonce()));
+    assert(verificationCache().hits()                   == 5 * MINED + 1);
+    assert(verificationCache().misses()                 == MINED + 3);
+    // and stays out of the cache
+    assert(!first.hashMatches(block.getHash(), prevHash, "forger", block.getNonce()));
+    assert(verificationCache().misses()                 == MINED + 4);
+
+    verificationCache().resetCounters();
+    assert(verificationCache().hits() + verificationCache().misses() == 0);
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testVerificationCache Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testBatchVerification(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testBatchVerification"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // messages with different prefixes, lengths and block counts, on every kernel this CPU has
+    std::vector<std::string> texts;
+    std::vector<Sha256Prefix> prefixes;
+    std::vector<long long> nonces;
+    for(int i = 0; i < 53; i++){
+        texts.push_back(std::string(64, 'a' + i % 26) + "Peer_" + std::to_string(i) + std::string(i % 7 == 0 ? 40 : 0, 'x'));
+        prefixes.push_back(Sha256Prefix(texts.back()));
+        nonces.push_back(i % 5 == 0 ? -i : 1000 * i);
+    }
+    const std::vector<std::string> kernels = {"scalar", "avx2", "sha-ni"};
+    const std::string defaultKernel = sha256Kernel();
+    for(auto kernel = kernels.begin(); kernel != kernels.end(); kernel++){
+        if(!setSha256Kernel(*kernel)){
+            continue;
+        }
+        std::vector<Digest> digests(texts.size());
+        sha256Messages(prefixes.data(), nonces.data(), (int)texts.size(), digests.data());
+        for(int i = 0; i < texts.size(); i++){
+            std::string expected;
+            picosha2::hash256_hex_string(texts[i] + std::to_string(nonces[i]), expected);
+            assert(digestHex(digests[i])                == expected);
+        }
+    }
+    assert(setSha256Kernel(defaultKernel));
+
+    ///////////////////////////////////////
+    // a long chain caught up on a pool and on the miner's own thread ends on the same blocks
+    const int LENGTH = 3000;
+    BitcoinMiner builder("builder");
+    Blockchain chain(true);
+    chain.createBlock(1, "-1_-1", "genesisHash:-1", {"src"});
+    for(int i = 2; i < LENGTH; i++){
+        const std::string prevHash = splitHash(chain.getBlockAt(i - 1).getHash()).getHash();
+        chain.createBlock(i, prevHash, builder.blockSHA(prevHash, "src", i) + ":" + std::to_string(i), {"src"});
+    }
+    const std::vector<int> threads = {4, 1};
+    for(int t = 0; t < threads.size(); t++){
+        verificationCache().clear();
+        BitcoinMiner::setVerifyThreads(threads[t]);
+        BitcoinMiner follower("follower");
+        follower.preformComputation(); // genesis
+        const auto start = std::chrono::steady_clock::now();
+        follower.catchUpAndVerify(&chain);
+        log<< LENGTH<< " blocks verified on "<< threads[t]<< " threads in "<< std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()<< "s"<< std::endl;
+        assert(follower.getCurChain()->getTip()         == chain.getTip());
+        assert(verificationCache().misses()             == LENGTH - 2);
+    }
+    verificationCache().clear();
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testBatchVerification Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testHeadersFirstRelay(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testHeadersFirstRelay"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // wire sizes
+    BitcoinMessage inv(INV, "sizes");
+    inv.refs.push_back(BlockRef());
+    assert(inv.size()                                   == MESSAGE_HEADER_BYTES + 1 + INV_ENTRY_BYTES);
+    BitcoinMessage headers(HEADERS, "sizes");
+    headers.blocks.resize(MAX_HEADERS);
+    assert(headers.size()                               == MESSAGE_HEADER_BYTES + 3 + (BLOCK_HEADER_BYTES + 1) * MAX_HEADERS);
+    BitcoinMessage blocks(BLOCK, "sizes");
+    blocks.blocks.resize(2);
+    assert(blocks.size()                                == 2 * (MESSAGE_HEADER_BYTES + DEFAULT_BLOCK_BYTES));
+
+    ///////////////////////////////////////
+    // leader - near - far in a line, far only hears of blocks through near's relay
+    BitcoinMiner leader("relayLeader");
+    BitcoinMiner near("relayNear");
+    BitcoinMiner far("relayFar");
+    leader.addNeighbor(near, 1);
+    near.addNeighbor(leader, 1);
+    near.addNeighbor(far, 1);
+    far.addNeighbor(near, 1);
+    leader.setHashRate(1 << 14);
+    while(leader.getCurChain()->getChainSize() < 4){
+        leader.preformComputation();
+    }
+    const int mined = leader.getCurChain()->getChainSize() - 1;
+    for(int round = 0; round < 50; round++){
+        leader.readBlock();
+        leader.transmit();
+        near.readBlock();
+        near.transmit();
+        far.readBlock();
+        far.transmit();
+    }
+    assert(near.getCurChain()->getTip()                 == leader.getCurChain()->getTip());
+    assert(far.getCurChain()->getTip()                  == leader.getCurChain()->getTip());
+    // each block crossed each link once, and both ends of a link count the same bytes
+    assert(leader.bytesSent(BLOCK)                      == mined * (MESSAGE_HEADER_BYTES + DEFAULT_BLOCK_BYTES));
+    assert(near.bytesSent(BLOCK)                        == mined * (MESSAGE_HEADER_BYTES + DEFAULT_BLOCK_BYTES));
+    assert(leader.linkTraffic("relayNear").bytesSent    == near.linkTraffic("relayLeader").bytesReceived);
+    assert(near.linkTraffic("relayLeader").bytesSent    == leader.linkTraffic("relayNear").bytesReceived);
+    assert(near.linkTraffic("relayFar").bytesSent       == far.linkTraffic("relayNear").bytesReceived);
+    assert(far.bytesSent()                              == far.linkTraffic("relayNear").bytesSent);
+    assert(leader.linkTraffic("relayFar").messagesSent  == 0);
+
+    ///////////////////////////////////////
+    // a miner on a shorter branch gets the headers past the fork, then only those blocks
+    BitcoinMiner rival("relayRival");
+    rival.setHashRate(1 << 14);
+    Blockchain shared(*leader.getCurChain());
+    shared.truncate(4);
+    rival.setCurChain(shared);
+    rival.preformComputation();
+    assert(*rival.getCurChain()->getBlockAt(4).getPublishers().begin() == "relayRival");
+    leader.addNeighbor(rival, 1);
+    rival.addNeighbor(leader, 1);
+    leader.resetTraffic();
+    const int before = leader.getCurChain()->getChainSize();
+    while(leader.getCurChain()->getChainSize() == before){
+        leader.preformComputation();
+    }
+    for(int round = 0; round < 50; round++){
+        leader.readBlock();
+        leader.transmit();
+        rival.readBlock();
+        rival.transmit();
+    }
+    assert(rival.getCurChain()->getTip()                == leader.getCurChain()->getTip());
+    assert(rival.getBeaten());
+    assert(leader.bytesSent(HEADERS)                    > 0);
+    assert(leader.bytesSent(BLOCK)                      == (leader.getCurChain()->getChainSize() - 4) * (MESSAGE_HEADER_BYTES + DEFAULT_BLOCK_BYTES));
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testHeadersFirstRelay Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
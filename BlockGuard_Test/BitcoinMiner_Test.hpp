@@ -0,0 +1,34 @@
+//
+//  BitcoinMiner_Test.hpp
+//  BlockGuard
+//
+//  Tests for the proof of work miner in jmuzina_bitcoin.
+//
+
+#ifndef BitcoinMiner_Test_hpp
+#define BitcoinMiner_Test_hpp
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include "../BlockGuard/jmuzina_bitcoin/BitcoinMiner.hpp"
+
+void RunBitcoinMinerTest        (std::string filepath);
+
+void testShaKernels             (std::ostream &log); // test every kernel this CPU has hashes nonce batches the same as picosha2
+void testHashRate               (std::ostream &log); // test a per step hash budget finds the same blocks in fewer steps
+void testMidstate               (std::ostream &log); // test hashing from a cached midstate matches hashing the whole message
+void testDifficultyTarget       (std::ostream &log); // test binary targets, whole zero bits and thresholds in between
+void testSampledMining          (std::ostream &log); // test drawn solutions come at the target's rate, sleep until due and still verify
+void testBlockStore             (std::ostream &log); // test chains share one block tree, copies are tip handles and dead blocks are dropped
+void testForkPoint              (std::ostream &log); // test the last common ancestor of two chains and catching up across a fork
+void testVerificationCache      (std::ostream &log); // test a block is hashed by the first miner that verifies it and looked up after
+void testBatchVerification      (std::ostream &log); // test unrelated messages hash right in the lanes and a long catch up verifies on a pool
+void testHeadersFirstRelay      (std::ostream &log); // test blocks reach miners through inv, headers and getdata only, and every byte is counted
+
+
+#endif /* BitcoinMiner_Test_hpp */
@@ -21,6 +21,16 @@ void runNetworkTests(std::string filepath){
     testOneDelay(log);
     testRandomDelay(log);
     testPoissonDelay(log);
+    testChannelDelivery(log);
+    testThreadedRounds(log);
+    testPeerIndex(log);
+    testPacketHeader(log);
+    testTopologies(log);
+    testRandomStreams(log);
+    testRunFastForward(log);
+    testActiveSet(log);
+    testMulticast(log);
+    testPacketMove(log);
 }
 void testSize(std::ostream &log){
     log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testSize"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
@@ -332,3 +342,700 @@ void testPoissonDelay(std::ostream &log){
     }
     log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPoissonDelay Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
 }
+void testChannelDelivery(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testChannelDelivery"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // delay 1 arrives on the next receive
+    ExamplePeer a = ExamplePeer("A");
+    ExamplePeer b = ExamplePeer("B");
+    a.setLogFile(log);
+    b.setLogFile(log);
+    a.addNeighbor(b, 1);
+    b.addNeighbor(a, 1);
+
+    a.preformComputation(); // one message to self and one to B
+    a.transmit();
+    assert(a.getInStream().size()   == 1); // self messages skip the channel
+    assert(b.inFlight()             == 1);
+    assert(b.getInStream().size()   == 0);
+    b.receive();
+    assert(b.inFlight()             == 0);
+    assert(b.getInStream().size()   == 1);
+    assert(b.getInStream()[0].sourceId() == "A");
+
+    ///////////////////////////////////////
+    // channels are FIFO and only one packet lands per round
+    ExamplePeer c = ExamplePeer("C");
+    ExamplePeer d = ExamplePeer("D");
+    c.setLogFile(log);
+    d.setLogFile(log);
+    int delay = 5;
+    c.addNeighbor(d, delay);
+    d.addNeighbor(c, delay);
+
+    c.preformComputation();
+    c.preformComputation();
+    c.transmit();
+    assert(d.inFlight()             == 2);
+    int rounds = 0;
+    while(d.getInStream().empty()){
+        d.receive();
+        rounds++;
+        assert(rounds <= delay);
+    }
+    assert(d.getInStream().size()   == 1);
+    assert(d.getInStream()[0].id()  == "0");
+    d.receive(); // the second packet only starts its delay once the first has arrived
+    rounds = 1;
+    while(d.getInStream().size() < 2){
+        d.receive();
+        rounds++;
+        assert(rounds <= delay);
+    }
+    assert(d.getInStream()[1].id()  == "1");
+    assert(d.inFlight()             == 0);
+
+    ///////////////////////////////////////
+    // idle rounds deliver nothing
+    for(int i = 0; i < 100; i++){
+        d.receive();
+    }
+    assert(d.getInStream().size()   == 2);
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testChannelDelivery Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testThreadedRounds(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testThreadedRounds"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // every worker gets a contiguous chunk and together they cover every index once
+    ThreadPool pool(4);
+    assert(pool.size() == 4);
+    std::vector<int> visits(103, 0);
+    std::vector<int> chunkStart(4, -1);
+    pool.parallelFor(103, [&](int begin, int end, int worker){
+        chunkStart[worker] = begin;
+        for(int i = begin; i < end; i++){
+            visits[i]++;
+        }
+    });
+    for(int i = 0; i < visits.size(); i++){
+        assert(visits[i] == 1);
+    }
+    for(int worker = 1; worker < chunkStart.size(); worker++){
+        assert(chunkStart[worker] > chunkStart[worker - 1]);
+    }
+
+    ///////////////////////////////////////
+    // with delay one there is no randomness, so a threaded network must deliver exactly what a serial one does
+    int peers = 16;
+    Network<ExampleMessage, ExamplePeer> serial = Network<ExampleMessage, ExamplePeer>();
+    serial.setToOne();
+    serial.initNetwork(peers);
+    serial.setLog(log);
+    Network<ExampleMessage, ExamplePeer> threaded = Network<ExampleMessage, ExamplePeer>();
+    threaded.setToOne();
+    threaded.initNetwork(peers);
+    threaded.setLog(log);
+    threaded.setThreads(4);
+    assert(serial.threads()     == 1);
+    assert(threaded.threads()   == 4);
+    // peers that read there neighbors in a step are never stepped in parallel
+    Network<bCoinMessage, bCoin_Peer> neighborReaders = Network<bCoinMessage, bCoin_Peer>();
+    neighborReaders.setThreads(4);
+    assert(neighborReaders.threads() == 1);
+
+    // ids are random so compare peers by there index in the network
+    std::map<std::string, int> serialIndex;
+    std::map<std::string, int> threadedIndex;
+    for(int i = 0; i < peers; i++){
+        serialIndex[serial[i]->id()] = i;
+        threadedIndex[threaded[i]->id()] = i;
+    }
+    for(int round = 0; round < 10; round++){
+        serial.receive();
+        threaded.receive();
+        for(int i = 0; i < peers; i++){
+            std::deque<Packet<ExampleMessage> > serialIn = serial[i]->getInStream();
+            std::deque<Packet<ExampleMessage> > threadedIn = threaded[i]->getInStream();
+            assert(serialIn.size() == threadedIn.size());
+            std::vector<std::pair<int, std::string> > serialArrivals;
+            std::vector<std::pair<int, std::string> > threadedArrivals;
+            for(int p = 0; p < serialIn.size(); p++){
+                serialArrivals.push_back(std::make_pair(serialIndex[serialIn[p].sourceId()], serialIn[p].id()));
+                threadedArrivals.push_back(std::make_pair(threadedIndex[threadedIn[p].sourceId()], threadedIn[p].id()));
+                // same round arrivals are in neighbor order, after the self loop packet pushed on transmit
+                if(p > 1){
+                    assert(threadedIn[p - 1].sourceId() <= threadedIn[p].sourceId());
+                }
+            }
+            std::sort(serialArrivals.begin(), serialArrivals.end());
+            std::sort(threadedArrivals.begin(), threadedArrivals.end());
+            assert(serialArrivals == threadedArrivals);
+        }
+        serial.preformComputation();
+        threaded.preformComputation();
+        serial.transmit();
+        threaded.transmit();
+        for(int i = 0; i < peers; i++){
+            assert(serial[i]->getMessageCount() == threaded[i]->getMessageCount());
+            assert(serial[i]->getClock()        == threaded[i]->getClock());
+            assert(serial[i]->inFlight()        == threaded[i]->inFlight());
+        }
+    }
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testThreadedRounds Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testPeerIndex(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPeerIndex"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // a network's peers get consecutive indices in id order
+    int peers = 50;
+    Network<ExampleMessage, ExamplePeer> system = Network<ExampleMessage, ExamplePeer>();
+    system.setToRandom();
+    system.setMinDelay(1);
+    system.setMaxDelay(10);
+    system.initNetwork(peers);
+    system.setLog(log);
+    uint32_t first = system[0]->index();
+    uint32_t last = system[0]->index();
+    for(int i = 0; i < peers; i++){
+        first = std::min(first, system[i]->index());
+        last = std::max(last, system[i]->index());
+    }
+    assert(last - first + 1 == peers);
+    for(int i = 0; i < peers; i++){
+        for(int j = 0; j < peers; j++){
+            assert((system[i]->index() < system[j]->index()) == (system[i]->id() < system[j]->id()));
+            if(i == j){
+                assert(system[i]->isNeighbor(system[j]->index()) == false);
+                continue;
+            }
+            // both ends of a link agree on the delay and the index and id lookups agree
+            assert(system[i]->isNeighbor(system[j]->index()));
+            assert(system[i]->getDelayToNeighbor(system[j]->index()) == system[i]->getDelayToNeighbor(system[j]->id()));
+            assert(system[i]->getDelayToNeighbor(system[j]->index()) == system[j]->getDelayToNeighbor(system[i]->index()));
+        }
+    }
+
+    ///////////////////////////////////////
+    // peers built on there own are linked by index too, in any order
+    ExamplePeer a = ExamplePeer("A");
+    ExamplePeer b = ExamplePeer("B");
+    ExamplePeer c = ExamplePeer("C");
+    ExamplePeer d = ExamplePeer("D");
+    c.addNeighbor(d, 4);
+    c.addNeighbor(a, 2);
+    assert(c.isNeighbor(a.index()));
+    assert(c.isNeighbor(b.index())      == false);
+    assert(c.isNeighbor(d.index()));
+    assert(c.getDelayToNeighbor(a.index()) == 2);
+    assert(c.getDelayToNeighbor(d.index()) == 4);
+    c.addNeighbor(b, 3);
+    assert(c.getDelayToNeighbor(a.index()) == 2);
+    assert(c.getDelayToNeighbor(b.index()) == 3);
+    assert(c.getDelayToNeighbor(d.index()) == 4);
+    c.removeNeighbor(a);
+    assert(c.isNeighbor(a.index())      == false);
+    assert(c.isNeighbor("A")            == false);
+    assert(c.getDelayToNeighbor(b.index()) == 3);
+    assert(c.getDelayToNeighbor(d.index()) == 4);
+    assert(c.neighbors().size()         == 2);
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPeerIndex Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testPacketHeader(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPacketHeader"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ExamplePeer a = ExamplePeer("A");
+    ExamplePeer b = ExamplePeer("B");
+
+    ///////////////////////////////////////
+    // numbered packets
+    Packet<ExampleMessage> numbered(7, b.index(), a.index());
+    assert(numbered.id()            == "7");
+    assert(numbered.seq()           == 7);
+    assert(numbered.source()        == a.index());
+    assert(numbered.target()        == b.index());
+    assert(numbered.sourceId()      == "A");
+    assert(numbered.targetId()      == "B");
+
+    ///////////////////////////////////////
+    // labeled packets share the interned label
+    Packet<ExampleMessage> labeled("request A 1", b.index(), a.index());
+    Packet<ExampleMessage> sameLabel("request A 1", a.index(), b.index());
+    Packet<ExampleMessage> otherLabel("request A 2", a.index(), b.index());
+    assert(labeled.id()             == "request A 1");
+    assert(labeled.seq()            == sameLabel.seq());
+    assert(labeled                  == sameLabel);
+    assert(labeled                  != otherLabel);
+    assert(labeled.seq()            != 7);
+    Packet<ExampleMessage> copy(labeled.seq(), a.index(), b.index());
+    assert(copy.id()                == "request A 1");
+
+    ///////////////////////////////////////
+    // renaming a peer renders the new name
+    b.setID("Z");
+    assert(numbered.targetId()      == "Z");
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPacketHeader Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+// true if edges has no self loops or repeated edges and every node is in [0, n)
+static bool isSimpleGraph(const std::vector<TopologyEdge> &edges, int n){
+    std::set<std::pair<int,int> > seen;
+    for(int i = 0; i < edges.size(); i++){
+        int a = std::min(edges[i].from, edges[i].to);
+        int b = std::max(edges[i].from, edges[i].to);
+        if(a == b || a < 0 || b >= n || seen.count(std::make_pair(a, b)) != 0){
+            return false;
+        }
+        seen.insert(std::make_pair(a, b));
+    }
+    return true;
+}
+
+static std::vector<int> degrees(const std::vector<TopologyEdge> &edges, int n){
+    std::vector<int> degree(n, 0);
+    for(int i = 0; i < edges.size(); i++){
+        degree[edges[i].from]++;
+        degree[edges[i].to]++;
+    }
+    return degree;
+}
+
+void testTopologies(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testTopologies"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+    std::default_random_engine generator(7);
+
+    ///////////////////////////////////////
+    // k-regular
+    std::vector<TopologyEdge> edges = kRegularTopology(1000, 8, generator);
+    assert(edges.size()                         == 1000 * 8 / 2);
+    assert(isSimpleGraph(edges, 1000));
+    std::vector<int> degree = degrees(edges, 1000);
+    for(int i = 0; i < degree.size(); i++){
+        assert(degree[i] == 8);
+    }
+    assert(kRegularTopology(5, 3, generator).empty()); // n*k is odd
+    // dense graphs, k close to n is built as the complement of a sparse one
+    int dense[][2] = {{100, 98}, {50, 48}, {100, 80}, {101, 100}, {100, 50}, {7, 4}};
+    for(int i = 0; i < 6; i++){
+        int n = dense[i][0];
+        int k = dense[i][1];
+        edges = kRegularTopology(n, k, generator);
+        assert(edges.size()                     == n * k / 2);
+        assert(isSimpleGraph(edges, n));
+        degree = degrees(edges, n);
+        for(int j = 0; j < degree.size(); j++){
+            assert(degree[j] == k);
+        }
+    }
+
+    ///////////////////////////////////////
+    // Erdos-Renyi, expected 0.01 * 2000*1999/2 = 19990 edges
+    edges = erdosRenyiTopology(2000, 0.01, generator);
+    assert(isSimpleGraph(edges, 2000));
+    assert(edges.size() > 18000 && edges.size() < 22000);
+    assert(erdosRenyiTopology(20, 1.0, generator).size()   == 20 * 19 / 2);
+    assert(erdosRenyiTopology(20, 0.0, generator).empty());
+
+    ///////////////////////////////////////
+    // Watts-Strogatz keeps the lattice's edge count, beta 0 is the lattice itself
+    edges = wattsStrogatzTopology(1000, 6, 0.2, generator);
+    assert(edges.size()                         == 1000 * 3);
+    assert(isSimpleGraph(edges, 1000));
+    edges = wattsStrogatzTopology(100, 4, 0.0, generator);
+    degree = degrees(edges, 100);
+    for(int i = 0; i < degree.size(); i++){
+        assert(degree[i] == 4);
+    }
+
+    ///////////////////////////////////////
+    // Barabasi-Albert, clique of m+1 then m edges per node
+    edges = barabasiAlbertTopology(1000, 3, generator);
+    assert(edges.size()                         == 6 + (1000 - 4) * 3);
+    assert(isSimpleGraph(edges, 1000));
+    degree = degrees(edges, 1000);
+    for(int i = 0; i < degree.size(); i++){
+        assert(degree[i] >= 3);
+    }
+
+    ///////////////////////////////////////
+    // edge list import
+    std::stringstream file("# a line\n0 1\n1 2 7 # with a delay\n\n2 3\n");
+    edges = readEdgeList(file);
+    assert(edges.size()                         == 3);
+    assert(edges[0].from == 0 && edges[0].to == 1 && edges[0].delay == -1);
+    assert(edges[1].from == 1 && edges[1].to == 2 && edges[1].delay == 7);
+
+    ///////////////////////////////////////
+    // networks wired by a topology
+    Network<ExampleMessage, ExamplePeer> system = Network<ExampleMessage, ExamplePeer>();
+    system.setToRandom();
+    system.setMinDelay(1);
+    system.setMaxDelay(5);
+    system.setToKRegular(4);
+    system.initNetwork(500);
+    system.setLog(log);
+    assert(system.topology()                    == K_REGULAR);
+    for(int i = 0; i < system.size(); i++){
+        assert(system[i]->neighbors().size()    == 4);
+        std::vector<std::string> neighbors = system[i]->neighbors();
+        for(int n = 0; n < neighbors.size(); n++){
+            assert(system[i]->getDelayToNeighbor(neighbors[n]) >= 1);
+            assert(system[i]->getDelayToNeighbor(neighbors[n]) <= 5);
+        }
+    }
+
+    file = std::stringstream("0 1\n1 2 7\n2 3\n");
+    system = Network<ExampleMessage, ExamplePeer>();
+    system.setToOne();
+    system.setToEdgeList(file);
+    system.initNetwork(4);
+    assert(system[0]->neighbors().size()        == 1);
+    assert(system[1]->neighbors().size()        == 2);
+    assert(system[3]->neighbors().size()        == 1);
+    assert(system[1]->getDelayToNeighbor(system[2]->index()) == 7);
+    assert(system[0]->getDelayToNeighbor(system[1]->index()) == 1);
+
+    // messages still flow over a sparse network
+    for(int round = 0; round < 5; round++){
+        system.receive();
+        system.preformComputation();
+        system.transmit();
+    }
+    assert(system[1]->getMessageCount()         == 5 * 3); // self and both neighbors each round
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testTopologies Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testRandomStreams(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testRandomStreams"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // a stream is a function of its key, any change to the key gives different numbers
+    RandomStream a(42, 1, 7, 3, DELAY_STREAM);
+    RandomStream b(42, 1, 7, 3, DELAY_STREAM);
+    std::vector<uint32_t> first;
+    for(int i = 0; i < 10; i++){
+        first.push_back(a());
+        assert(first.back()                         == b());
+    }
+    RandomStream otherSeed(43, 1, 7, 3, DELAY_STREAM);
+    RandomStream otherSpace(42, 2, 7, 3, DELAY_STREAM);
+    RandomStream otherPeer(42, 1, 8, 3, DELAY_STREAM);
+    RandomStream otherRound(42, 1, 7, 4, DELAY_STREAM);
+    RandomStream otherPurpose(42, 1, 7, 3, PROTOCOL_STREAM);
+    assert(otherSeed()                              != first[0]);
+    assert(otherSpace()                             != first[0]);
+    assert(otherPeer()                              != first[0]);
+    assert(otherRound()                             != first[0]);
+    assert(otherPurpose()                           != first[0]);
+    a.reset(42, 1, 7, 3, DELAY_STREAM);
+    assert(a()                                      == first[0]);
+
+    // a network's stream is keyed by its space and round
+    Network<ExampleMessage, ExamplePeer> system = Network<ExampleMessage, ExamplePeer>();
+    system.setStreamSpace(9);
+    system.receive();
+    RandomStream expected(simulationSeed(), 9, NETWORK_STREAM, 1, SHUFFLE_STREAM);
+    assert(system.random(SHUFFLE_STREAM)()          == expected());
+    assert(system.random(SHUFFLE_STREAM)()          == expected());
+
+    ///////////////////////////////////////
+    // two networks in the same space draw the same ids, edges and delays, whether they step serially or on threads
+    int peers = 32;
+    Network<ExampleMessage, ExamplePeer> serial = Network<ExampleMessage, ExamplePeer>();
+    Network<ExampleMessage, ExamplePeer> threaded = Network<ExampleMessage, ExamplePeer>();
+    assert(serial.streamSpace()                     != threaded.streamSpace());
+    serial.setStreamSpace(threaded.streamSpace());
+    serial.setToRandom();
+    serial.setMaxDelay(5);
+    serial.setToErdosRenyi(0.3);
+    serial.initNetwork(peers);
+    serial.setLog(log);
+    threaded.setToRandom();
+    threaded.setMaxDelay(5);
+    threaded.setToErdosRenyi(0.3);
+    threaded.initNetwork(peers);
+    threaded.setLog(log);
+    threaded.setThreads(4);
+    for(int i = 0; i < peers; i++){
+        assert(serial[i]->id()                      == threaded[i]->id());
+        assert(serial[i]->neighbors()               == threaded[i]->neighbors());
+        std::vector<std::string> neighbors = serial[i]->neighbors();
+        for(int n = 0; n < neighbors.size(); n++){
+            assert(serial[i]->getDelayToNeighbor(neighbors[n]) == threaded[i]->getDelayToNeighbor(neighbors[n]));
+        }
+    }
+    for(int round = 0; round < 20; round++){
+        serial.receive();
+        threaded.receive();
+        for(int i = 0; i < peers; i++){
+            std::deque<Packet<ExampleMessage> > serialIn = serial[i]->getInStream();
+            std::deque<Packet<ExampleMessage> > threadedIn = threaded[i]->getInStream();
+            assert(serialIn.size()                  == threadedIn.size());
+            for(int p = 0; p < serialIn.size(); p++){
+                assert(serialIn[p].sourceId()       == threadedIn[p].sourceId());
+                assert(serialIn[p].id()             == threadedIn[p].id());
+            }
+        }
+        serial.preformComputation();
+        threaded.preformComputation();
+        serial.transmit();
+        threaded.transmit();
+        for(int i = 0; i < peers; i++){
+            assert(serial[i]->inFlight()            == threaded[i]->inFlight());
+        }
+    }
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testRandomStreams Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testRunFastForward(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testRunFastForward"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // peers that wake every round are stepped every round
+    Network<ExampleMessage, ExamplePeer> example = Network<ExampleMessage, ExamplePeer>();
+    example.setToOne();
+    example.initNetwork(4);
+    example.setLog(log);
+    assert(example.run(5)                           == 5);
+    assert(example.round()                          == 5);
+    for(int i = 0; i < example.size(); i++){
+        assert(example[i]->getClock()               == 5);
+        assert(example[i]->getMessageCount()        == 5 * 4);
+    }
+
+    ///////////////////////////////////////
+    // with no timers and nothing in flight the network jumps straight to the end
+    Network<bCoinMessage, bCoin_Peer> quiet = Network<bCoinMessage, bCoin_Peer>();
+    quiet.setToOne();
+    quiet.initNetwork(3);
+    quiet.setLog(log);
+    assert(quiet.nextEvent()                        == NEVER);
+    assert(quiet.run(100)                           == 1);
+    for(int i = 0; i < quiet.size(); i++){
+        assert(quiet[i]->getClock()                 == 100);
+    }
+
+    ///////////////////////////////////////
+    // skipping idle rounds ends in the same state as stepping through them
+    int rounds = 80;
+    Network<bCoinMessage, bCoin_Peer> stepped = Network<bCoinMessage, bCoin_Peer>();
+    Network<bCoinMessage, bCoin_Peer> skipped = Network<bCoinMessage, bCoin_Peer>();
+    stepped.setStreamSpace(skipped.streamSpace());
+    stepped.setToRandom();
+    stepped.setMaxDelay(3);
+    stepped.initNetwork(4);
+    stepped.setLog(log);
+    skipped.setToRandom();
+    skipped.setMaxDelay(3);
+    skipped.initNetwork(4);
+    skipped.setLog(log);
+    for(int i = 0; i < stepped.size(); i++){
+        stepped[i]->setMineNextAt(30 + 7 * i);
+        skipped[i]->setMineNextAt(30 + 7 * i);
+    }
+    assert(skipped.nextEvent()                      == 30);
+    for(int round = 0; round < rounds; round++){
+        stepped.receive();
+        stepped.preformComputation();
+        stepped.transmit();
+    }
+    int steps = skipped.run(rounds);
+    assert(steps                                    <= rounds - 28); // rounds 2 to 29 are idle
+    assert(skipped.round()                          == rounds);
+    for(int i = 0; i < stepped.size(); i++){
+        assert(stepped[i]->getClock()               == skipped[i]->getClock());
+        assert(stepped[i]->getMineNextAt()          == skipped[i]->getMineNextAt());
+        assert(stepped[i]->getMessageCount()        == skipped[i]->getMessageCount());
+        assert(stepped[i]->inFlight()               == skipped[i]->inFlight());
+        assert(stepped[i]->getBlockchain()->getChainSize() == skipped[i]->getBlockchain()->getChainSize());
+    }
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testRunFastForward Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testActiveSet(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testActiveSet"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // peers that poll are stepped every round
+    Network<ExampleMessage, ExamplePeer> example = Network<ExampleMessage, ExamplePeer>();
+    example.setToOne();
+    example.initNetwork(8);
+    example.setLog(log);
+    for(int round = 0; round < 3; round++){
+        example.receive();
+        example.preformComputation();
+        example.transmit();
+        assert(example.activeCount()                == 8);
+    }
+
+    ///////////////////////////////////////
+    // miners are only stepped when they find a block or one arrives
+    Network<bCoinMessage, bCoin_Peer> miners = Network<bCoinMessage, bCoin_Peer>();
+    miners.setToOne();
+    miners.initNetwork(10);
+    miners.setLog(log);
+    miners[0]->setMineNextAt(3);
+    for(int round = 0; round < 4; round++){
+        miners.receive();
+        miners.preformComputation();
+        miners.transmit();
+    }
+    std::vector<int> active = miners.activeCounts();
+    assert(active.size()                            == 4);
+    assert(active[0]                                == 0);
+    assert(active[1]                                == 0);
+    assert(active[2]                                == 1); // miner 0 finds a block
+    assert(active[3]                                >= 9); // every other miner gets it
+    assert(miners[1]->getBlockchain()->getChainSize() > 1);
+
+    ///////////////////////////////////////
+    // a miner first stepped after its round has gone by still finds its block
+    Network<bCoinMessage, bCoin_Peer> late = Network<bCoinMessage, bCoin_Peer>();
+    late.setToOne();
+    late.initNetwork(3);
+    late.setLog(log);
+    late[0]->setMineNextAt(2);
+    late.fastForward(4);
+    assert(late[0]->nextWakeup()                    == 2);
+    late.receive();
+    late.preformComputation();
+    late.transmit();
+    assert(late.activeCount()                       == 1);
+    assert(late[0]->getBlockchain()->getChainSize() == 2);
+    assert(late[0]->nextWakeup()                    > late[0]->getClock());
+
+    ///////////////////////////////////////
+    // a woken peer is stepped once
+    Network<bCoinMessage, bCoin_Peer> quiet = Network<bCoinMessage, bCoin_Peer>();
+    quiet.setToOne();
+    quiet.initNetwork(10);
+    quiet.setLog(log);
+    quiet.receive();
+    quiet.preformComputation();
+    quiet.transmit();
+    assert(quiet.activeCount()                      == 0);
+    quiet[5]->wake();
+    quiet.receive();
+    quiet.preformComputation();
+    quiet.transmit();
+    assert(quiet.activeCount()                      == 1);
+    quiet.receive();
+    quiet.preformComputation();
+    quiet.transmit();
+    assert(quiet.activeCount()                      == 0);
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testActiveSet Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testMulticast(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testMulticast"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    Network<ExampleMessage, ExamplePeer> system = Network<ExampleMessage, ExamplePeer>();
+    system.setToOne();
+    system.initNetwork(6);
+    system.setLog(log);
+
+    ExampleMessage body;
+    body.aPeerId = system[0]->id();
+    body.message = "broadcast";
+    Packet<ExampleMessage> packet("multicast");
+    packet.setBody(body);
+
+    ///////////////////////////////////////
+    // one packet per neighbor, all pointing at the one body
+    system[0]->multicast(packet);
+    std::deque<Packet<ExampleMessage> > out = system[0]->getOutStream();
+    assert(out.size()                               == 5);
+    std::set<uint32_t> targets;
+    for(auto p = out.begin(); p != out.end(); p++){
+        assert(p->sharesBody(packet));
+        assert(p->source()                          == system[0]->index());
+        assert(p->id()                              == "multicast");
+        targets.insert(p->target());
+    }
+    assert(targets.size()                           == 5);
+    assert(targets.count(system[0]->index())        == 0);
+
+    ///////////////////////////////////////
+    // the body is still shared once it has been delivered
+    system.transmit();
+    for(int round = 0; round < 3; round++){
+        system.receive();
+    }
+    for(int i = 1; i < system.size(); i++){
+        std::deque<Packet<ExampleMessage> > in = system[i]->getInStream();
+        assert(in.size()                            == 1);
+        assert(in.front().sharesBody(packet));
+        assert(in.front().getMessage().message      == "broadcast");
+    }
+
+    ///////////////////////////////////////
+    // packets that were given there own body do not share it
+    Packet<ExampleMessage> other("multicast");
+    other.setBody(body);
+    assert(!other.sharesBody(packet));
+    assert(!Packet<ExampleMessage>(0).sharesBody(Packet<ExampleMessage>(0)));
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testMulticast Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void testPacketMove(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPacketMove"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    ///////////////////////////////////////
+    // a packet without a body reads as a default message
+    Packet<ExampleMessage> empty(0);
+    assert(empty.getMessage().message               == "");
+    assert(&empty.getMessage()                      == &Packet<ExampleMessage>(1).getMessage());
+
+    ///////////////////////////////////////
+    // getMessage is a view of the body, moving a packet hands the body over without copying it
+    ExampleMessage body;
+    body.message = "moved";
+    Packet<ExampleMessage> packet("move", 2, 1);
+    packet.setBody(std::move(body));
+    const ExampleMessage *stored = &packet.getMessage();
+    assert(&packet.getMessage()                     == stored);
+    Packet<ExampleMessage> moved(std::move(packet));
+    assert(&moved.getMessage()                      == stored);
+    assert(moved.id()                               == "move");
+    assert(moved.target()                           == 2);
+    assert(moved.source()                           == 1);
+    Packet<ExampleMessage> assigned(0);
+    assigned = std::move(moved);
+    assert(&assigned.getMessage()                   == stored);
+    assert(assigned.getMessage().message            == "moved");
+
+    ///////////////////////////////////////
+    // stream views see the same packets as the copies
+    Network<ExampleMessage, ExamplePeer> system = Network<ExampleMessage, ExamplePeer>();
+    system.setToOne();
+    system.initNetwork(4);
+    system.setLog(log);
+    system[0]->multicast(assigned);
+    assert(system[0]->outStream().size()            == system[0]->getOutStream().size());
+    assert(&system[0]->outStream().front().getMessage() == stored);
+    system.transmit();
+    assert(system[0]->outStream().empty());
+    for(int round = 0; round < 3; round++){
+        system.receive();
+    }
+    for(int i = 1; i < system.size(); i++){
+        assert(system[i]->inStream().size()         == 1);
+        assert(&system[i]->inStream().front().getMessage() == stored);
+    }
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testPacketMove Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
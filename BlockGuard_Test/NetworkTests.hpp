@@ -12,8 +12,10 @@
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
+#include <set>
 #include "./../BlockGuard/Common/Network.hpp"
 #include "./../BlockGuard/ExamplePeer.hpp"
+#include "./../BlockGuard/bCoin/bCoin_Peer.hpp"
 
 void runNetworkTests    (std::string filepath);
 
@@ -25,5 +27,16 @@ void testOneDelay       (std::ostream &log); // test setDelayOne
 void testRandomDelay    (std::ostream &log); // test random distribution
 void testPoissonDelay   (std::ostream &log); // test poisson distribution
 
+void testChannelDelivery(std::ostream &log); // test packets arrive in order and with in the channel delay
+void testThreadedRounds (std::ostream &log); // test stepping on a thread pool matches stepping serially
+void testPeerIndex      (std::ostream &log); // test peers are addressed by dense indices
+void testPacketHeader   (std::ostream &log); // test packet ids and endpoints render back to names
+void testTopologies     (std::ostream &log); // test the sparse topology builders and wiring a network with them
+void testRandomStreams  (std::ostream &log); // test counter based streams make serial and threaded runs draw the same numbers
+void testRunFastForward (std::ostream &log); // test run skips idle rounds and ends where stepping every round does
+void testActiveSet      (std::ostream &log); // test only peers with work are stepped and the active set is counted
+void testMulticast      (std::ostream &log); // test a multicast stores its body once and every receiver shares it
+void testPacketMove     (std::ostream &log); // test moving packets and reading bodies and streams in place never copies the body
+
 
 #endif /* NetworkTests_hpp */
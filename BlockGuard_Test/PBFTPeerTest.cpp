@@ -26,6 +26,10 @@ void RunPBFT_Tests(std::string pathToFile){
     viewChange(log);
     byzantineCommit(log);
     waitingTime(log);
+    quorumTracking(log);
+    checkpoints(log);
+    pipelining(log);
+    batching(log);
 }
 
 void constructors(std::ostream &log){
@@ -1225,7 +1229,7 @@ void multiRequest(std::ostream &log){
     assert(a.getRequestLog()[0].client_id           == "B");
     assert(a.getRequestLog()[0].view                == 0);
     assert(a.getRequestLog()[0].type                == REQUEST);
-    assert(a.getRequestLog()[0].commit_round               == 0);
+    assert(a.getRequestLog()[0].commit_round               == 1);
     assert(a.getRequestLog()[0].phase               == IDEAL);
     assert(a.getRequestLog()[0].result              == 0);
     
@@ -1314,21 +1318,21 @@ void multiRequest(std::ostream &log){
     assert(a.getRequestLog()[0].client_id           == "B");
     assert(a.getRequestLog()[0].view                == 0);
     assert(a.getRequestLog()[0].type                == REQUEST);
-    assert(a.getRequestLog()[0].commit_round               == 0);
+    assert(a.getRequestLog()[0].commit_round               == 1);
     assert(a.getRequestLog()[0].phase               == IDEAL);
     assert(a.getRequestLog()[0].result              == 0);
     assert(a.getRequestLog()[1].sequenceNumber      == -1);
     assert(a.getRequestLog()[1].client_id           == "A");
     assert(a.getRequestLog()[1].view                == 0);
     assert(a.getRequestLog()[1].type                == REQUEST);
-    assert(a.getRequestLog()[1].commit_round               == 2);
+    assert(a.getRequestLog()[1].commit_round               == 3);
     assert(a.getRequestLog()[1].phase               == IDEAL);
     assert(a.getRequestLog()[1].result              == 0);
     assert(a.getRequestLog()[2].sequenceNumber      == -1);
     assert(a.getRequestLog()[2].client_id           == "C");
     assert(a.getRequestLog()[2].view                == 0);
     assert(a.getRequestLog()[2].type                == REQUEST);
-    assert(a.getRequestLog()[2].commit_round               == 1);
+    assert(a.getRequestLog()[2].commit_round               == 2);
     assert(a.getRequestLog()[2].phase               == IDEAL);
     assert(a.getRequestLog()[2].result              == 0);
 
@@ -1420,21 +1424,21 @@ void multiRequest(std::ostream &log){
     assert(a.getRequestLog()[0].client_id           == "B");
     assert(a.getRequestLog()[0].view                == 0);
     assert(a.getRequestLog()[0].type                == REQUEST);
-    assert(a.getRequestLog()[0].commit_round               == 0);
+    assert(a.getRequestLog()[0].commit_round               == 1);
     assert(a.getRequestLog()[0].phase               == IDEAL);
     assert(a.getRequestLog()[0].result              == 0);
     assert(a.getRequestLog()[1].sequenceNumber      == -1);
     assert(a.getRequestLog()[1].client_id           == "A");
     assert(a.getRequestLog()[1].view                == 0);
     assert(a.getRequestLog()[1].type                == REQUEST);
-    assert(a.getRequestLog()[1].commit_round               == 2);
+    assert(a.getRequestLog()[1].commit_round               == 3);
     assert(a.getRequestLog()[1].phase               == IDEAL);
     assert(a.getRequestLog()[1].result              == 0);
     assert(a.getRequestLog()[2].sequenceNumber      == -1);
     assert(a.getRequestLog()[2].client_id           == "C");
     assert(a.getRequestLog()[2].view                == 0);
     assert(a.getRequestLog()[2].type                == REQUEST);
-    assert(a.getRequestLog()[2].commit_round               == 1);
+    assert(a.getRequestLog()[2].commit_round               == 2);
     assert(a.getRequestLog()[2].phase               == IDEAL);
     assert(a.getRequestLog()[2].result              == 0);
 
@@ -1504,28 +1508,28 @@ void multiRequest(std::ostream &log){
     assert(a.getRequestLog()[0].client_id           == "B");
     assert(a.getRequestLog()[0].view                == 0);
     assert(a.getRequestLog()[0].type                == REQUEST);
-    assert(a.getRequestLog()[0].commit_round        == 0);
+    assert(a.getRequestLog()[0].commit_round        == 1);
     assert(a.getRequestLog()[0].phase               == IDEAL);
     assert(a.getRequestLog()[0].result              == 0);
     assert(a.getRequestLog()[1].sequenceNumber      == -1);
     assert(a.getRequestLog()[1].client_id           == "A");
     assert(a.getRequestLog()[1].view                == 0);
     assert(a.getRequestLog()[1].type                == REQUEST);
-    assert(a.getRequestLog()[1].commit_round        == 2);
+    assert(a.getRequestLog()[1].commit_round        == 3);
     assert(a.getRequestLog()[1].phase               == IDEAL);
     assert(a.getRequestLog()[1].result              == 0);
     assert(a.getRequestLog()[2].sequenceNumber      == -1);
     assert(a.getRequestLog()[2].client_id           == "C");
     assert(a.getRequestLog()[2].view                == 0);
     assert(a.getRequestLog()[2].type                == REQUEST);
-    assert(a.getRequestLog()[2].commit_round               == 1);
+    assert(a.getRequestLog()[2].commit_round               == 2);
     assert(a.getRequestLog()[2].phase               == IDEAL);
     assert(a.getRequestLog()[2].result              == 0);
     assert(a.getRequestLog()[3].sequenceNumber      == -1);
     assert(a.getRequestLog()[3].client_id           == "B");
     assert(a.getRequestLog()[3].view                == 0);
     assert(a.getRequestLog()[3].type                == REQUEST);
-    assert(a.getRequestLog()[3].commit_round               == 3);
+    assert(a.getRequestLog()[3].commit_round               == 4);
     assert(a.getRequestLog()[3].phase               == IDEAL);
     assert(a.getRequestLog()[3].result              == 0);
 
@@ -1557,28 +1561,28 @@ void multiRequest(std::ostream &log){
     assert(a.getRequestLog()[0].client_id           == "A");
     assert(a.getRequestLog()[0].view                == 0);
     assert(a.getRequestLog()[0].type                == REQUEST);
-    assert(a.getRequestLog()[0].commit_round               == 2);
+    assert(a.getRequestLog()[0].commit_round               == 3);
     assert(a.getRequestLog()[0].phase               == IDEAL);
     assert(a.getRequestLog()[0].result              == 0);
     assert(a.getRequestLog()[1].sequenceNumber      == -1);
     assert(a.getRequestLog()[1].client_id           == "C");
     assert(a.getRequestLog()[1].view                == 0);
     assert(a.getRequestLog()[1].type                == REQUEST);
-    assert(a.getRequestLog()[1].commit_round               == 1);
+    assert(a.getRequestLog()[1].commit_round               == 2);
     assert(a.getRequestLog()[1].phase               == IDEAL);
     assert(a.getRequestLog()[1].result              == 0);
     assert(a.getRequestLog()[2].sequenceNumber      == -1);
     assert(a.getRequestLog()[2].client_id           == "B");
     assert(a.getRequestLog()[2].view                == 0);
     assert(a.getRequestLog()[2].type                == REQUEST);
-    assert(a.getRequestLog()[2].commit_round               == 3);
+    assert(a.getRequestLog()[2].commit_round               == 4);
     assert(a.getRequestLog()[2].phase               == IDEAL);
     assert(a.getRequestLog()[2].result              == 0);
     assert(a.getRequestLog()[3].sequenceNumber      == -1);
     assert(a.getRequestLog()[3].client_id           == "A");
     assert(a.getRequestLog()[3].view                == 0);
     assert(a.getRequestLog()[3].type                == REQUEST);
-    assert(a.getRequestLog()[3].commit_round               == 5);
+    assert(a.getRequestLog()[3].commit_round               == 6);
     assert(a.getRequestLog()[3].phase               == IDEAL);
     assert(a.getRequestLog()[3].result              == 0);
     
@@ -2431,3 +2435,327 @@ void waitingTime(std::ostream &log){
     
     log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"waitingTime Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
 }
+
+void quorumTracking(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"quorumTracking"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    QuorumTracker quorum;
+    assert(quorum.votes(0, 1, PREPARE)                  == 0);
+    assert(quorum.tally(0, 1, COMMIT, 2).correct        == 0);
+    
+    // a voter is counted once per phase
+    assert(quorum.add(PREPARE, 0, 1, 0, 2, false)     == true);
+    assert(quorum.add(PREPARE, 0, 1, 0, 2, false)     == false);
+    assert(quorum.add(PREPARE, 0, 1, 1, 2, false)     == true);
+    assert(quorum.votes(0, 1, PREPARE)                  == 2);
+    assert(quorum.votes(0, 1, COMMIT)                   == 0);
+    assert(quorum.add(COMMIT, 0, 1, 0, 2, false)      == true);
+    assert(quorum.votes(0, 1, COMMIT)                   == 1);
+    
+    // views and sequence numbers are counted apart
+    assert(quorum.add(PREPARE, 1, 1, 0, 2, false)     == true);
+    assert(quorum.add(PREPARE, 0, 2, 0, 2, false)     == true);
+    assert(quorum.votes(1, 1, PREPARE)                  == 1);
+    assert(quorum.votes(0, 2, PREPARE)                  == 1);
+    assert(quorum.size()                                == 3);
+    
+    // commits are tallied by result and by byzantine
+    assert(quorum.add(COMMIT, 0, 1, 1, 2, true)       == true);
+    assert(quorum.add(COMMIT, 0, 1, 2, 3, false)      == true);
+    assert(quorum.votes(0, 1, COMMIT)                   == 3);
+    assert(quorum.tally(0, 1, COMMIT, 2).correct        == 1);
+    assert(quorum.tally(0, 1, COMMIT, 2).byzantine      == 1);
+    assert(quorum.tally(0, 1, COMMIT, 3).correct        == 1);
+    assert(quorum.tally(0, 1, COMMIT, 4).correct        == 0);
+    
+    // more voters than one bitmap word
+    for(int i = 0; i < 100; i++){
+        quorum.add(PREPARE, 0, 3, i, 0, false);
+        quorum.add(PREPARE, 0, 3, i, 0, false);
+    }
+    assert(quorum.votes(0, 3, PREPARE)                  == 100);
+    
+    quorum.erase(1, 0);
+    assert(quorum.votes(0, 1, PREPARE)                  == 0);
+    assert(quorum.votes(1, 1, PREPARE)                  == 1);
+    quorum.erase(std::set<int>{1, 3});
+    assert(quorum.votes(1, 1, PREPARE)                  == 0);
+    assert(quorum.votes(0, 3, PREPARE)                  == 0);
+    assert(quorum.votes(0, 2, PREPARE)                  == 1);
+    quorum.erase(2);
+    assert(quorum.size()                                == 0);
+    
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"quorumTracking Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void checkpoints(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"checkpoints"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+    
+    PBFT_Peer a = PBFT_Peer("A");
+    PBFT_Peer b = PBFT_Peer("B");
+    PBFT_Peer c = PBFT_Peer("C");
+    a.setLogFile(log);
+    b.setLogFile(log);
+    c.setLogFile(log);
+    
+    a.addNeighbor(b, 1);
+    a.addNeighbor(c, 1);
+    
+    b.addNeighbor(a, 1);
+    b.addNeighbor(c, 1);
+    
+    c.addNeighbor(b, 1);
+    c.addNeighbor(a, 1);
+    
+    a.setFaultTolerance(1);
+    b.setFaultTolerance(1);
+    c.setFaultTolerance(1);
+    
+    a.init();
+    b.init();
+    c.init();
+    
+    assert(a.lowWatermark()                             == 0);
+    assert(a.checkpointEntries()                        == 0);
+    assert(a.checkpointDigest()                         == b.checkpointDigest());
+    
+    // commit one request at a time until there are two checkpoints and some
+    int requests = 2 * CHECKPOINT_INTERVAL + 5;
+    for(int request = 0; request < requests; request++){
+        a.makeRequest();
+        for(int round = 0; round < 20 && c.getLedger().size() <= request; round++){
+            a.receive();
+            b.receive();
+            c.receive();
+            a.preformComputation();
+            b.preformComputation();
+            c.preformComputation();
+            a.transmit();
+            b.transmit();
+            c.transmit();
+        }
+        assert(a.getLedger().size()                     == request + 1);
+        assert(b.getLedger().size()                     == request + 1);
+        assert(c.getLedger().size()                     == request + 1);
+        if(request + 1 == CHECKPOINT_INTERVAL){
+            assert(a.checkpointEntries()                == CHECKPOINT_INTERVAL);
+        }
+    }
+    a.log();
+    b.log();
+    c.log();
+    
+    assert(a.lowWatermark()                             == requests);
+    assert(b.lowWatermark()                             == requests);
+    assert(c.lowWatermark()                             == requests);
+    assert(a.checkpointEntries()                        == 2 * CHECKPOINT_INTERVAL);
+    assert(b.checkpointEntries()                        == 2 * CHECKPOINT_INTERVAL);
+    assert(c.checkpointEntries()                        == 2 * CHECKPOINT_INTERVAL);
+    assert(a.checkpointDigest()                         == b.checkpointDigest());
+    assert(a.checkpointDigest()                         == c.checkpointDigest());
+    
+    // nothing committed is left in the logs
+    assert(a.getPrePrepareLog().size()                  == 0);
+    assert(b.getPrePrepareLog().size()                  == 0);
+    assert(c.getPrePrepareLog().size()                  == 0);
+    assert(a.getPrepareLog().size()                     == 0);
+    assert(b.getPrepareLog().size()                     == 0);
+    assert(c.getPrepareLog().size()                     == 0);
+    assert(a.getCommitLog().size()                      == 0);
+    assert(b.getCommitLog().size()                      == 0);
+    assert(c.getCommitLog().size()                      == 0);
+    
+    // a peer with a different ledger has a different checkpoint
+    PBFT_Peer d = PBFT_Peer("D");
+    PBFT_Peer e = PBFT_Peer("E");
+    d.setLogFile(log);
+    e.setLogFile(log);
+    d.addNeighbor(e, 1);
+    e.addNeighbor(d, 1);
+    d.setFaultTolerance(1);
+    e.setFaultTolerance(1);
+    d.init();
+    e.init();
+    for(int request = 0; request < CHECKPOINT_INTERVAL; request++){
+        d.makeRequest();
+        for(int round = 0; round < 20 && e.getLedger().size() <= request; round++){
+            d.receive();
+            e.receive();
+            d.preformComputation();
+            e.preformComputation();
+            d.transmit();
+            e.transmit();
+        }
+    }
+    assert(d.checkpointEntries()                        == CHECKPOINT_INTERVAL);
+    assert(d.checkpointDigest()                         == e.checkpointDigest());
+    assert(d.checkpointDigest()                         != a.checkpointDigest());
+    
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"checkpoints Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+// rounds for 4 peers with links of delay to commit requests made at once by the primary
+static int pipelinedRounds(std::ostream &log, int window, int requests, int delay, int &mostInFlight, bool byzantinePrimary = false,
+                           int batchSize = 1, int batchWait = 0, std::map<int, int> *batchSizes = nullptr){
+    std::vector<PBFT_Peer> peers = {PBFT_Peer("A"), PBFT_Peer("B"), PBFT_Peer("C"), PBFT_Peer("D")};
+    for(int i = 0; i < peers.size(); i++){
+        peers[i].setLogFile(log);
+        for(int j = 0; j < peers.size(); j++){
+            if(i != j){
+                peers[i].addNeighbor(peers[j], delay);
+            }
+        }
+        peers[i].setFaultTolerance(0.3);
+        peers[i].setWindow(window);
+        peers[i].setBatching(batchSize, batchWait);
+    }
+    for(int i = 0; i < peers.size(); i++){
+        peers[i].init();
+    }
+    assert(peers[0].isPrimary()                         == true);
+    if(byzantinePrimary){
+        peers[0].makeByzantine();
+    }
+    for(int i = 0; i < requests; i++){
+        peers[0].makeRequest();
+    }
+    
+    mostInFlight = 0;
+    int rounds = 0;
+    bool done = false;
+    while(!done && rounds < 1000){
+        for(int i = 0; i < peers.size(); i++){
+            peers[i].receive();
+        }
+        for(int i = 0; i < peers.size(); i++){
+            peers[i].preformComputation();
+            mostInFlight = std::max(mostInFlight, peers[i].inFlight());
+            assert(peers[i].inFlight()                  <= window);
+        }
+        for(int i = 0; i < peers.size(); i++){
+            peers[i].transmit();
+        }
+        rounds++;
+        done = true;
+        for(int i = 0; i < peers.size(); i++){
+            done = done && peers[i].getLedger().size() == requests;
+        }
+    }
+    assert(done                                         == true);
+    
+    // every peer commits the same requests in sequence order
+    for(int i = 0; i < peers.size(); i++){
+        std::vector<PBFT_Message> ledger = peers[i].getLedger();
+        for(int seq = 0; seq < requests; seq++){
+            assert(ledger[seq].sequenceNumber           == seq + 1);
+            assert(ledger[seq].result                   == peers[0].getLedger()[seq].result);
+            int expected = ledger[seq].operation == ADD ? ledger[seq].operands.first + ledger[seq].operands.second : ledger[seq].operands.first - ledger[seq].operands.second;
+            assert(ledger[seq].result                   == expected);
+            assert(ledger[seq].client_id                == "A");
+            assert(ledger[seq].batch                    == nullptr);
+            assert(ledger[seq].defeated                 == false);
+        }
+        assert(peers[i].inFlight()                      == 0);
+        assert(peers[i].getPhase()                      == IDEAL);
+    }
+    if(batchSizes != nullptr){
+        *batchSizes = peers[0].batchSizes();
+    }
+    return rounds;
+}
+
+void pipelining(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"pipelining"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+    
+    PBFT_Peer a = PBFT_Peer("A");
+    assert(a.getWindow()                                == 1);
+    a.setWindow(0);
+    assert(a.getWindow()                                == 1);
+    a.setWindow(4);
+    assert(a.getWindow()                                == 4);
+    
+    int mostInFlight = 0;
+    int serial = pipelinedRounds(log, 1, 16, 1, mostInFlight);
+    assert(mostInFlight                                 == 1);
+    int pipelined = pipelinedRounds(log, 4, 16, 1, mostInFlight);
+    assert(mostInFlight                                 == 4);
+    // the primary's links carry a pre-prepare and a commit per request, that bounds the speed up
+    assert(pipelined * 3                                < serial * 2);
+    pipelinedRounds(log, 4, 16, 3, mostInFlight);
+    log<< "one at a time: "<< serial<< " rounds, window of 4: "<< pipelined<< " rounds"<< std::endl;
+    
+    // a window wider than the work
+    pipelinedRounds(log, 16, 5, 1, mostInFlight);
+    assert(mostInFlight                                 == 5);
+    
+    // a byzantine primary forces a view change, the next primary restarts everything in flight in order
+    pipelinedRounds(log, 4, 4, 1, mostInFlight, true);
+    assert(mostInFlight                                 == 4);
+    
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"pipelining Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
+
+void batching(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"batching"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+    
+    PBFT_Peer a = PBFT_Peer("A");
+    assert(a.getBatchSize()                             == 1);
+    assert(a.getBatchWait()                             == 0);
+    a.setBatching(0, -1);
+    assert(a.getBatchSize()                             == 1);
+    assert(a.getBatchWait()                             == 0);
+    
+    int mostInFlight = 0;
+    std::map<int, int> sizes;
+    int single = pipelinedRounds(log, 1, 12, 1, mostInFlight, false, 1, 0, &sizes);
+    assert(sizes                                        == (std::map<int, int>{{1, 12}}));
+    
+    // full batches go at once
+    int batched = pipelinedRounds(log, 1, 12, 1, mostInFlight, false, 4, 0, &sizes);
+    assert(sizes                                        == (std::map<int, int>{{4, 3}}));
+    assert(batched * 2                                  < single);
+    log<< "one request per pre-prepare: "<< single<< " rounds, four: "<< batched<< " rounds"<< std::endl;
+    
+    // without waiting a partial batch goes with what is there
+    pipelinedRounds(log, 1, 6, 1, mostInFlight, false, 4, 0, &sizes);
+    assert(sizes                                        == (std::map<int, int>{{2, 1}, {4, 1}}));
+    
+    // a partial batch waits for more requests before it goes
+    int waited = pipelinedRounds(log, 1, 2, 1, mostInFlight, false, 4, 10, &sizes);
+    assert(sizes                                        == (std::map<int, int>{{2, 1}}));
+    int unwaited = pipelinedRounds(log, 1, 2, 1, mostInFlight, false, 4, 0, &sizes);
+    // the requests are made in round 0, unwaited they go in round 1 and waiting in round 10
+    assert(waited                                       == unwaited + 9);
+    
+    // a primary holding a partial batch sleeps until the batch is due
+    PBFT_Peer b = PBFT_Peer("B");
+    PBFT_Peer c = PBFT_Peer("C");
+    PBFT_Peer d = PBFT_Peer("D");
+    a.setLogFile(log);
+    a.addNeighbor(b, 1);
+    a.addNeighbor(c, 1);
+    a.addNeighbor(d, 1);
+    a.setFaultTolerance(0.3);
+    a.setBatching(4, 10);
+    a.init();
+    assert(a.isPrimary()                                == true);
+    a.makeRequest();
+    a.makeRequest();
+    a.receive();
+    a.step();
+    assert(a.getRequestLog().size()                     == 2);
+    assert(a.nextWakeup()                               == 10);
+    a.makeRequest();
+    a.makeRequest();
+    assert(a.nextWakeup()                               == 2); // the batch is full
+    
+    // batches in a pipeline
+    pipelinedRounds(log, 2, 12, 1, mostInFlight, false, 3, 0, &sizes);
+    assert(sizes                                        == (std::map<int, int>{{3, 4}}));
+    assert(mostInFlight                                 == 2);
+    
+    // a byzantine primary's batches are restarted whole by the next primary
+    pipelinedRounds(log, 2, 6, 1, mostInFlight, true, 3, 0, &sizes);
+    
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"batching Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
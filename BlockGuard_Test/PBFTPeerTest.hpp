@@ -29,5 +29,9 @@ void slowPeerConnection     (std::ostream &log);// test when peer has slow conne
 void viewChange             (std::ostream &log);// test that peers do a view change if the leader is byzantine
 void byzantineCommit        (std::ostream &log);// test that if the leader is byzantine and (1/3)+1 peers are also byzantine then transaction is committed 
 void waitingTime            (std::ostream &log);// test that the time from submittion to confirmation is accurate
+void quorumTracking         (std::ostream &log);// test that votes are counted once per voter and tallied by result
+void checkpoints            (std::ostream &log);// test that the low watermark and checkpoint digest follow the ledger
+void pipelining             (std::ostream &log);// test that a window of requests in flight commits in order and sooner
+void batching               (std::ostream &log);// test that the primary batches requests and each still gets a ledger entry
 
 #endif /* PBFTPeerTest_hpp */
@@ -30,6 +30,7 @@ void RunPBFTRefComTest (std::string filepath){
     testShuffle(log);
     testByzantineVsDelay(log);
     testDelay(log);
+    testRefComActiveSet(log);
 }
 
 void testInit(std::ostream &log){
@@ -1664,3 +1665,44 @@ void testDelay(std::ostream &log){
     
     log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testDelay"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
 }
+
+void testRefComActiveSet(std::ostream &log){
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testRefComActiveSet"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+
+    PBFTReferenceCommittee refCom = PBFTReferenceCommittee();
+    refCom.setLog(log);
+    refCom.setMaxDelay(1);
+    refCom.setToRandom();
+    refCom.setGroupSize(2);
+    refCom.setFaultTolerance(1);
+    refCom.initNetwork(32);
+    refCom.setMaxSecurityLevel(2);
+    refCom.setMinSecurityLevel(2);
+
+    refCom.queueRequest();
+    double securityLevel = refCom.getRequestQueue().front().securityLevel;
+    refCom.makeRequest(); // queues a second request, there are enough groups for only one committee per round
+    int committeeSize = securityLevel * refCom.getGroupSize();
+
+    // every peer is stepped once to find its primary, after that only the committee has work
+    refCom.receive();
+    refCom.preformComputation();
+    refCom.transmit();
+    assert(refCom.activeCounts().size()             == 1);
+    assert(refCom.activeCounts().back()             == 32);
+    for(int round = 0; round < 10; round++){
+        refCom.receive();
+        refCom.preformComputation();
+        refCom.transmit();
+        assert(refCom.activeCounts().back()         <= committeeSize);
+    }
+    assert(refCom.getGlobalLedger().size()          == 1);
+
+    // once consensus is done nobody is stepped
+    refCom.receive();
+    refCom.preformComputation();
+    refCom.transmit();
+    assert(refCom.activeCounts().back()             == 0);
+
+    log<< std::endl<< "###############################"<< std::setw(LOG_WIDTH)<< std::left<<"!!!"<<"testRefComActiveSet Complete"<< std::setw(LOG_WIDTH)<< std::right<<"!!!"<<"###############################"<< std::endl;
+}
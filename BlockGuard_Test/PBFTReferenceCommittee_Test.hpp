@@ -35,5 +35,6 @@ void testByzantineConfirmationRate  (std::ostream &log); // test that committees
 void testShuffle                    (std::ostream &log); // test that shuffling byzantine works and does not change thier state (erase ledger, messages etc)
 void testByzantineVsDelay           (std::ostream &log); // test that committees are set-back (do view changes) with var delay
 void testDelay                      (std::ostream &log); // test that delay is set correctly
+void testRefComActiveSet            (std::ostream &log); // test that only peers in a committee are stepped
 
 #endif /* PBFTReferenceCommittee_Test_hpp */